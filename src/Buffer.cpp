@@ -1,73 +1,95 @@
 #include "Buffer.h"
 #include "CryptoHelper.h"
 #include <endian.h>
+#include <string.h>
+#include <algorithm>
 
 const Buffer Buffer::empty = Buffer();
 
+void Buffer::growToCapacity(size_t minimumCapacity) {
+    // grow geometrically, so a series of appends only reallocates a handful of times
+    size_t newCapacity = std::max(minimumCapacity, _capacity * 2);
+    uint8_t* newData = _arena != nullptr ? _arena->allocate(newCapacity) : nullptr;
+    if(newData == nullptr) {
+        newData = static_cast<uint8_t*>(malloc(newCapacity));
+    }
+    if(newData == nullptr && newCapacity > minimumCapacity) {
+        // doubling asked for more than we need, try again with just enough
+        newCapacity = minimumCapacity;
+        newData = static_cast<uint8_t*>(malloc(newCapacity));
+    }
+    if(newData == nullptr) {
+        // callers write straight into the grown storage and have no way to report a failure,
+        // so stop here instead of writing through a null pointer, like std::vector did before
+        log_e("Buffer: out of memory growing to %u bytes", static_cast<unsigned>(newCapacity));
+        abort();
+    }
+    memcpy(newData, _data, _size);
+    releaseStorage();
+    _data = newData;
+    _capacity = newCapacity;
+}
+
+void Buffer::releaseStorage() {
+    if(isHeapAllocated()) {
+        free(_data);
+    }
+    _data = _inlineBytes;
+    _capacity = inlineCapacity;
+}
+
+void Buffer::moveFrom(Buffer& other) {
+    if(other.isHeapAllocated()) {
+        // heap storage can just be taken over
+        releaseStorage();
+        _data = other._data;
+        _capacity = other._capacity;
+        _size = other._size;
+
+        other._data = other._inlineBytes;
+        other._capacity = inlineCapacity;
+    } else {
+        // inline and arena storage belong to `other`, so we copy the bytes into our own storage
+        clear();
+        append(other._data, other._size);
+    }
+    other._size = 0;
+}
+
 Buffer Buffer::md5() const {
     return CryptoHelper::md5(data(), size());
 }
 
-Buffer Buffer::aesCbc128Decrypt(Buffer key, Buffer iv) const {
+Buffer Buffer::aesCbc128Decrypt(const Buffer& key, const Buffer& iv) const {
     return CryptoHelper::aesCbc128Decrypt(key.data(), iv.data(), data(), size());
 }
 
-Buffer Buffer::aesCbc128Encrypt(Buffer key, Buffer iv) const {
+Buffer Buffer::aesCbc128Encrypt(const Buffer& key, const Buffer& iv) const {
     return CryptoHelper::aesCbc128Encrypt(key.data(), iv.data(), data(), size());
 }
 
-Buffer Buffer::aesCbc256Encrypt(const Buffer key, Buffer iv) const {
+Buffer Buffer::aesCbc256Encrypt(const Buffer& key, const Buffer& iv) const {
     return CryptoHelper::aesCbc256Encrypt(key.data(), iv.data(), data(), size());
 }
-Buffer Buffer::aesCbc256Decrypt(Buffer key, Buffer iv) const {
+
+Buffer Buffer::aesCbc256Decrypt(const Buffer& key, const Buffer& iv) const {
     return CryptoHelper::aesCbc256Decrypt(key.data(), iv.data(), data(), size());
 }
 
-uint32_t Buffer::asBigEndianUnsignedInt() const {
-    switch(size()) {
-        case 0: 
-            return 0;
-
-        case 1: 
-           return static_cast<uint32_t>(_bytes[0]);
-        
-        case 2:
-         return be16toh(*reinterpret_cast<const uint16_t*>(&_bytes[0]));
-
-        case 3: {
-            uint8_t fakeBytes[4] = {0, _bytes[1], _bytes[2], _bytes[3]};
-            return be32toh(*reinterpret_cast<const uint32_t*>(&fakeBytes[0]));
-        }
-
-        case 4: 
-            return be32toh(*reinterpret_cast<const uint32_t*>(&_bytes[0]));
+void Buffer::aesCbc128DecryptInPlace(const Buffer& key, const Buffer& iv) {
+    CryptoHelper::aesCbc128DecryptInPlace(key.data(), iv.data(), data(), size());
+}
 
-        default:
-            return 0;
-    }
+void Buffer::aesCbc128EncryptInPlace(const Buffer& key, const Buffer& iv) {
+    CryptoHelper::aesCbc128EncryptInPlace(key.data(), iv.data(), data(), size());
 }
-int32_t Buffer::asBigEndianSignedInt() const {
-    switch(size()) {
-        case 0: 
-            return 0;
-
-        case 1: 
-            return static_cast<int32_t>(_bytes[0]);
-        
-        case 2:
-         return be16toh(*reinterpret_cast<const int16_t*>(&_bytes[0]));
-
-        case 3: {
-            uint8_t fakeBytes[4] = {0, _bytes[1], _bytes[2], _bytes[3]};
-            return be32toh(*reinterpret_cast<const int32_t*>(&fakeBytes[0]));
-        }
 
-        case 4: 
-            return be32toh(*reinterpret_cast<const int32_t*>(&_bytes[0]));
+uint32_t Buffer::asBigEndianUnsignedInt() const {
+    return view().asBigEndianUnsignedInt();
+}
 
-        default:
-            return 0;
-    }
+int32_t Buffer::asBigEndianSignedInt() const {
+    return view().asBigEndianSignedInt();
 }
 
 uint16_t Buffer::crc16() const { 
@@ -79,7 +101,8 @@ Buffer Buffer::aesInitializationVector() {
 }
 
 void Buffer::append(uint8_t value) {
-    _bytes.push_back(value);
+    if(_size + 1 > _capacity) growToCapacity(_size + 1);
+    _data[_size++] = value;
 }
 
 void Buffer::appendLittleEndian(uint16_t value) {
@@ -130,21 +153,41 @@ void Buffer::appendBigEndianWithNumberOfBytes(size_t size, size_t numberOfBytes)
 }
 
 void Buffer::append(const Buffer& buffer) {
-    _bytes.insert(_bytes.end(), buffer._bytes.begin(), buffer._bytes.end());
+    append(buffer._data, buffer._size);
+}
+
+void Buffer::append(const BufferView& view) {
+    append(view.data(), view.size());
 }
 
 void Buffer::append(const uint8_t* data, size_t length) {
-    _bytes.insert(_bytes.end(), data, data + length);
+    if(length == 0) return;
+    if(_size + length > _capacity) {
+        // `data` might point into ourselves (e.g. `buffer.append(buffer)`), so
+        // we need to find it back after moving our storage
+        bool isAppendingFromSelf = data >= _data && data < _data + _size;
+        size_t selfOffset = isAppendingFromSelf ? static_cast<size_t>(data - _data) : 0;
+        growToCapacity(_size + length);
+        if(isAppendingFromSelf) data = _data + selfOffset;
+    }
+    memcpy(_data + _size, data, length);
+    _size += length;
 }
 
 void Buffer::append(const Buffer& buffer, size_t start, size_t length) {
-    _bytes.insert(_bytes.end(), buffer._bytes.begin() + start, buffer._bytes.begin() + start + length);   
+    append(buffer._data + start, length);
 }
 
 void Buffer::append(const String& str) {
     append(reinterpret_cast<const uint8_t*>(str.c_str()), str.length());
 }
 
+void Buffer::appendRepeated(uint8_t value, size_t count) {
+    if(_size + count > _capacity) growToCapacity(_size + count);
+    memset(_data + _size, value, count);
+    _size += count;
+}
+
 void Buffer::appendPackedInt(unsigned int value) {
     while(true) {
         uint8_t currentByte = value & 0x7F;
@@ -160,67 +203,35 @@ void Buffer::appendPackedInt(unsigned int value) {
 }
 
 unsigned int Buffer::readPackedInt(size_t& offset) const {
-    size_t numberOfBytesRead = 0;
-    unsigned int value  = 0;
-    while(offset < size()) {
-        uint8_t byte = _bytes[offset];
-        value |= (byte & 0x7F) << (numberOfBytesRead * 7);
-        offset += 1;
-        numberOfBytesRead += 1;
-        if((byte & 0x80)  == 0) {
-            break;
-        }
-    }
-
-    return value;
+    return view().readPackedInt(offset);
 }
 
 uint8_t Buffer::readUint8(size_t& offset) const {
-    if(offset + 1 > size()) return 0;
-    return _bytes[offset++];
+    return view().readUint8(offset);
 }
 
 uint16_t Buffer::readBigEndianUint16(size_t& offset) const {
-    if(offset + 2 > size()) return 0;
-    const uint16_t* bigEndianValue = reinterpret_cast<const uint16_t*>(&_bytes[offset]);
-    offset += 2;
-    return be16toh(*bigEndianValue);
+    return view().readBigEndianUint16(offset);
 }
 
-uint16_t Buffer::readBigEndianUint32(size_t& offset) const {
-    if(offset + 4 > size()) return 0;
-    const uint32_t* bigEndianValue = reinterpret_cast<const uint32_t*>(&_bytes[offset]);
-    offset += 4;
-    return be32toh(*bigEndianValue);
+uint32_t Buffer::readBigEndianUint32(size_t& offset) const {
+    return view().readBigEndianUint32(offset);
 }
 
 Buffer Buffer::readBuffer(size_t& offset, size_t length) const {
-    if(offset + length > size()) return Buffer();
-    
-    Buffer result = this->subRangeWithStartAndLength(offset, length);
-    offset += length;
-    return result;
+    return Buffer(view().readBuffer(offset, length));
 }
 
 void Buffer::padToNumberOfBytes(size_t length, uint8_t byteValue) {
     size_t numBytesToAdd = length - (size() % length);
     if(numBytesToAdd < length)
-        _bytes.insert(_bytes.end(), numBytesToAdd, byteValue);
+        appendRepeated(byteValue, numBytesToAdd);
 }
 
 String Buffer::toHexString() const {
-  String output;
-  for(int i = 0; i < size(); i++) {
-    String byteHex = String(_bytes[i], 16);
-    if(byteHex.length() == 1)
-      output += "0";
-
-    output += byteHex;
-  }
-
-  return output;
+    return view().toHexString();
 }
 
 String Buffer::debugDescription() const {
-    return toHexString() + " (" +  String(size()) + String(size() == 1 ? " byte)" : " bytes)");
+    return view().debugDescription();
 }
\ No newline at end of file
@@ -3,42 +3,96 @@
 
 #include <Arduino.h>
 #include <stdint.h>
-#include <vector>
-
-/// This is a class that holds  
+#include <initializer_list>
+#include <string>
+
+#include "BufferView.h"
+#include "BufferArena.h"
+
+/// This is a class that holds a growable range of bytes. Small payloads (GATT packets,
+/// IVs, digests, keys) are stored inline in the object itself, only when the buffer grows
+/// past `inlineCapacity` bytes its contents move to the heap.
+///
+/// A buffer created with a `BufferArena` takes its out-of-line storage from that arena instead of the heap,
+/// and must not outlive the `BufferArenaScope` it was created in. Moving or copying such a buffer into a buffer
+/// without an arena copies the bytes, so arena memory never escapes its scope that way.
 class Buffer {
+public:
+    static const size_t inlineCapacity = 32;
+
 private:
-    std::vector<uint8_t> _bytes;
+    uint8_t* _data = _inlineBytes;
+    size_t _size = 0;
+    size_t _capacity = inlineCapacity;
+    BufferArena* _arena = nullptr;
+    uint8_t _inlineBytes[inlineCapacity];
+
+    bool isInline() const { return _data == _inlineBytes; }
+    bool isHeapAllocated() const { return !isInline() && (_arena == nullptr || !_arena->owns(_data)); }
+    void growToCapacity(size_t minimumCapacity);
+    void releaseStorage();
+    void moveFrom(Buffer& other);
 
 public:
     Buffer(const size_t length) {
-        _bytes = std::vector<uint8_t>(length, 0);
+        appendRepeated(0, length);
     }
 
     Buffer(const void* ptr, const size_t length) {
-        const uint8_t* bytesPtr = static_cast<const uint8_t*>(ptr);
-        _bytes = std::vector<uint8_t>(bytesPtr, bytesPtr + length);
+        append(static_cast<const uint8_t*>(ptr), length);
     }
 
     Buffer(const std::string& binaryString) {
-        const uint8_t* bytesPtr = reinterpret_cast<const uint8_t*>(binaryString.data());
-        _bytes = std::vector<uint8_t>(bytesPtr, bytesPtr + binaryString.size());        
+        append(reinterpret_cast<const uint8_t*>(binaryString.data()), binaryString.size());
+    }
+
+    explicit Buffer(const BufferView& view) {
+        append(view.data(), view.size());
     }
 
     Buffer(std::initializer_list<uint8_t> bytes) {
-        _bytes = bytes;
+        append(bytes.begin(), bytes.size());
     }
 
     Buffer() {}
 
+    explicit Buffer(BufferArena& arena) : _arena(&arena) {}
+
+    Buffer(const Buffer& other) {
+        append(other._data, other._size);
+    }
+
+    Buffer(Buffer&& other) {
+        moveFrom(other);
+    }
+
+    Buffer& operator=(const Buffer& other) {
+        if(this != &other) {
+            clear();
+            append(other._data, other._size);
+        }
+        return *this;
+    }
+
+    Buffer& operator=(Buffer&& other) {
+        if(this != &other) {
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    ~Buffer() {
+        releaseStorage();
+    }
+
     static const Buffer empty;
 
     uint8_t& operator[](size_t index) {
-        return _bytes[index];
+        return _data[index];
     }
 
     uint8_t operator[](size_t index) const {
-        return _bytes[index];
+        return _data[index];
     }
 
     Buffer operator+(const Buffer& other) {
@@ -48,8 +102,28 @@ public:
     }
 
     // MARK: - get data
-    uint8_t* data() const { return const_cast<uint8_t*>(&_bytes.at(0)); }
-    const size_t size() const { return _bytes.size(); }
+    uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+    size_t capacity() const { return _capacity; }
+
+    /// a non-owning view on our bytes, valid until this buffer is modified or destroyed
+    BufferView view() const { return BufferView(_data, _size); }
+    operator BufferView() const { return view(); }
+
+    // MARK: - Capacity
+
+    /// reserves room for `capacity` bytes, so appending up to that size doesn't reallocate
+    void reserve(size_t capacity) { if(capacity > _capacity) growToCapacity(capacity); }
+
+    /// removes all bytes, but keeps the allocated capacity around for reuse
+    void clear() { _size = 0; }
+
+    /// sets the size to `length`, growing the capacity if needed. Bytes added this way are
+    /// not initialized, this is for code that writes them directly through `data()`
+    void resize(size_t length) {
+        if(length > _capacity) growToCapacity(length);
+        _size = length;
+    }
 
     // MARK: - Slicing
     Buffer subRangeWithStartAndLength(size_t start, size_t length) const {
@@ -76,9 +150,11 @@ public:
     void appendBigEndian(int32_t value);
     void appendBigEndianWithNumberOfBytes(size_t size, size_t numberOfBytes); //supports 1, 2, 4
     void append(const Buffer& buffer);
+    void append(const BufferView& view);
     void append(const uint8_t* data, size_t length);
     void append(const Buffer& buffer, size_t start, size_t length);
     void append(const String& str);
+    void appendRepeated(uint8_t value, size_t count);
 
     // MARK: - Packed Int
 
@@ -93,20 +169,22 @@ public:
     // reading
     uint8_t readUint8(size_t& offset) const;
     uint16_t readBigEndianUint16(size_t& offset) const;
-    uint16_t readBigEndianUint32(size_t& offset) const;
+    uint32_t readBigEndianUint32(size_t& offset) const;
     unsigned int readPackedInt(size_t& offset) const;
     Buffer readBuffer(size_t& offset, size_t length) const;
 
     // MARK: - Converting
     Buffer md5() const;
-    Buffer aesCbc128Decrypt(Buffer key, Buffer iv) const;
-    Buffer aesCbc128Encrypt(Buffer key, Buffer iv) const;
-    Buffer aesCbc256Encrypt(Buffer key, Buffer iv) const;
-    Buffer aesCbc256Decrypt(Buffer key, Buffer iv) const;
+    Buffer aesCbc128Decrypt(const Buffer& key, const Buffer& iv) const;
+    Buffer aesCbc128Encrypt(const Buffer& key, const Buffer& iv) const;
+    Buffer aesCbc256Encrypt(const Buffer& key, const Buffer& iv) const;
+    Buffer aesCbc256Decrypt(const Buffer& key, const Buffer& iv) const;
+    void aesCbc128DecryptInPlace(const Buffer& key, const Buffer& iv);
+    void aesCbc128EncryptInPlace(const Buffer& key, const Buffer& iv);
 
     uint32_t asBigEndianUnsignedInt() const;
     int32_t asBigEndianSignedInt() const;
-    String asString() const { return String(data(), static_cast<unsigned int>(size())); }
+    String asString() const { return view().asString(); }
 
     String toHexString() const;
     String debugDescription() const;
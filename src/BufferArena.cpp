@@ -0,0 +1,15 @@
+#include "BufferArena.h"
+
+uint8_t* BufferArena::allocate(size_t length) {
+    if(_bytes == nullptr) {
+        _bytes = static_cast<uint8_t*>(malloc(_capacity));
+        if(_bytes == nullptr) return nullptr;
+    }
+
+    size_t alignedLength = (length + 7) & ~size_t(7);
+    if(alignedLength > _capacity - _used) return nullptr;
+
+    uint8_t* result = _bytes + _used;
+    _used += alignedLength;
+    return result;
+}
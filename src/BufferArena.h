@@ -0,0 +1,81 @@
+#ifndef BUFFER_ARENA_1234
+#define BUFFER_ARENA_1234
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/// A bump allocator for short-lived message buffers: allocating moves a pointer forward,
+/// freeing is done all at once by rewinding to an earlier mark (see `BufferArenaScope`).
+/// The backing memory is allocated once, on first use, and reused for every message after that.
+/// When the arena is full, `allocate()` returns nullptr and callers fall back to the heap.
+class BufferArena {
+private:
+    uint8_t* _bytes = nullptr;
+    size_t _capacity = 0;
+    size_t _used = 0;
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+
+public:
+    explicit BufferArena(size_t capacity) : _capacity(capacity) {}
+    ~BufferArena() { free(_bytes); }
+
+    /// returns `length` bytes of 8-byte aligned memory, or nullptr if the arena is exhausted
+    uint8_t* allocate(size_t length);
+
+    /// true if `pointer` was handed out by this arena
+    bool owns(const void* pointer) const {
+        const uint8_t* bytePointer = static_cast<const uint8_t*>(pointer);
+        return _bytes != nullptr && bytePointer >= _bytes && bytePointer < _bytes + _capacity;
+    }
+
+    size_t capacity() const { return _capacity; }
+    size_t used() const { return _used; }
+
+    size_t mark() const { return _used; }
+    void rewind(size_t mark) { if(mark < _used) _used = mark; }
+    void reset() { _used = 0; }
+};
+
+/// Everything allocated from the arena while this scope is alive is released in O(1) when
+/// it goes out of scope. Scopes can be nested, as long as they are strictly LIFO.
+class BufferArenaScope {
+private:
+    BufferArena& _arena;
+    size_t _mark;
+
+    BufferArenaScope(const BufferArenaScope&) = delete;
+    BufferArenaScope& operator=(const BufferArenaScope&) = delete;
+
+public:
+    explicit BufferArenaScope(BufferArena& arena) : _arena(arena), _mark(arena.mark()) {}
+    ~BufferArenaScope() { _arena.rewind(_mark); }
+};
+
+/// A standard allocator on top of a `BufferArena`, so std containers can live in a message scope.
+/// Deallocating arena memory is a no-op: it comes back when the enclosing scope ends.
+template<typename T> class BufferArenaAllocator {
+public:
+    typedef T value_type;
+
+    BufferArena* arena;
+
+    explicit BufferArenaAllocator(BufferArena* arena) : arena(arena) {}
+    template<typename U> BufferArenaAllocator(const BufferArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        void* memory = arena->allocate(count * sizeof(T));
+        return static_cast<T*>(memory != nullptr ? memory : malloc(count * sizeof(T)));
+    }
+
+    void deallocate(T* pointer, size_t) {
+        if(!arena->owns(pointer)) free(pointer);
+    }
+
+    template<typename U> bool operator==(const BufferArenaAllocator<U>& other) const { return arena == other.arena; }
+    template<typename U> bool operator!=(const BufferArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+#endif//BUFFER_ARENA_1234
@@ -0,0 +1,121 @@
+#include "BufferView.h"
+#include "Buffer.h"
+#include "CryptoHelper.h"
+
+Buffer BufferView::md5() const {
+    return CryptoHelper::md5(data(), size());
+}
+
+Buffer BufferView::aesCbc128Decrypt(const BufferView& key, const BufferView& iv, BufferArena* arena) const {
+    return CryptoHelper::aesCbc128Decrypt(key.data(), iv.data(), data(), size(), arena);
+}
+
+Buffer BufferView::aesCbc128Encrypt(const BufferView& key, const BufferView& iv, BufferArena* arena) const {
+    return CryptoHelper::aesCbc128Encrypt(key.data(), iv.data(), data(), size(), arena);
+}
+
+uint32_t BufferView::asBigEndianUnsignedInt() const {
+    switch(size()) {
+        case 0:
+            return 0;
+
+        case 1:
+            return static_cast<uint32_t>(_data[0]);
+
+        case 2:
+            return (static_cast<uint32_t>(_data[0]) << 8) | _data[1];
+
+        case 3:
+            return (static_cast<uint32_t>(_data[0]) << 16) | (static_cast<uint32_t>(_data[1]) << 8) | _data[2];
+
+        case 4:
+            return (static_cast<uint32_t>(_data[0]) << 24) | (static_cast<uint32_t>(_data[1]) << 16) | (static_cast<uint32_t>(_data[2]) << 8) | _data[3];
+
+        default:
+            return 0;
+    }
+}
+
+int32_t BufferView::asBigEndianSignedInt() const {
+    switch(size()) {
+        case 0:
+            return 0;
+
+        case 1:
+            return static_cast<int32_t>(_data[0]);
+
+        case 2:
+            return static_cast<int16_t>(asBigEndianUnsignedInt());
+
+        case 3:
+        case 4:
+            return static_cast<int32_t>(asBigEndianUnsignedInt());
+
+        default:
+            return 0;
+    }
+}
+
+uint16_t BufferView::crc16() const {
+    return CryptoHelper::crc16(data(), size());
+}
+
+unsigned int BufferView::readPackedInt(size_t& offset) const {
+    size_t numberOfBytesRead = 0;
+    unsigned int value  = 0;
+    while(offset < size()) {
+        uint8_t byte = _data[offset];
+        value |= (byte & 0x7F) << (numberOfBytesRead * 7);
+        offset += 1;
+        numberOfBytesRead += 1;
+        if((byte & 0x80)  == 0) {
+            break;
+        }
+    }
+
+    return value;
+}
+
+uint8_t BufferView::readUint8(size_t& offset) const {
+    if(offset + 1 > size()) return 0;
+    return _data[offset++];
+}
+
+uint16_t BufferView::readBigEndianUint16(size_t& offset) const {
+    if(offset + 2 > size()) return 0;
+    uint16_t value = static_cast<uint16_t>(subRangeWithStartAndLength(offset, 2).asBigEndianUnsignedInt());
+    offset += 2;
+    return value;
+}
+
+uint32_t BufferView::readBigEndianUint32(size_t& offset) const {
+    if(offset + 4 > size()) return 0;
+    uint32_t value = subRangeWithStartAndLength(offset, 4).asBigEndianUnsignedInt();
+    offset += 4;
+    return value;
+}
+
+BufferView BufferView::readBuffer(size_t& offset, size_t length) const {
+    if(offset + length > size()) return BufferView();
+
+    BufferView result = subRangeWithStartAndLength(offset, length);
+    offset += length;
+    return result;
+}
+
+String BufferView::toHexString() const {
+  String output;
+  for(size_t i = 0; i < size(); i++) {
+    String byteHex = String(_data[i], 16);
+    if(byteHex.length() == 1)
+      output += "0";
+
+    output += byteHex;
+  }
+
+  return output;
+}
+
+String BufferView::debugDescription() const {
+    return toHexString() + " (" +  String(size()) + String(size() == 1 ? " byte)" : " bytes)");
+}
@@ -0,0 +1,66 @@
+#ifndef BUFFER_VIEW_1234
+#define BUFFER_VIEW_1234
+
+#include <Arduino.h>
+#include <stdint.h>
+
+class Buffer;
+class BufferArena;
+
+/// A non-owning view on a range of bytes: a pointer and a length. The bytes
+/// are owned by someone else (a `Buffer`, a BLE notification, ...) and must outlive the view.
+/// Slicing and reading a view never copies or allocates.
+class BufferView {
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+
+public:
+    BufferView() {}
+    BufferView(const void* ptr, const size_t length) : _data(static_cast<const uint8_t*>(ptr)), _size(length) {}
+
+    uint8_t operator[](size_t index) const {
+        return _data[index];
+    }
+
+    // MARK: - get data
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+
+    // MARK: - Slicing
+    BufferView subRangeWithStartAndLength(size_t start, size_t length) const {
+        return BufferView(_data + start, length);
+    }
+
+    BufferView suffixFrom(size_t offset) const {
+        return subRangeWithStartAndLength(offset, size() - offset);
+    }
+
+    BufferView prefixUntil(size_t length) const {
+        return subRangeWithStartAndLength(0, length);
+    }
+
+    // reading
+    uint8_t readUint8(size_t& offset) const;
+    uint16_t readBigEndianUint16(size_t& offset) const;
+    uint32_t readBigEndianUint32(size_t& offset) const;
+    unsigned int readPackedInt(size_t& offset) const;
+    BufferView readBuffer(size_t& offset, size_t length) const;
+
+    // MARK: - Converting
+    Buffer md5() const;
+    Buffer aesCbc128Decrypt(const BufferView& key, const BufferView& iv, BufferArena* arena = nullptr) const;
+    Buffer aesCbc128Encrypt(const BufferView& key, const BufferView& iv, BufferArena* arena = nullptr) const;
+
+    uint32_t asBigEndianUnsignedInt() const;
+    int32_t asBigEndianSignedInt() const;
+    String asString() const { return String(reinterpret_cast<const char*>(data()), static_cast<unsigned int>(size())); }
+
+    String toHexString() const;
+    String debugDescription() const;
+
+    // crc
+    uint16_t crc16() const;
+};
+
+#endif//BUFFER_VIEW_1234
@@ -0,0 +1,117 @@
+#ifndef BYTE_READER_1234
+#define BYTE_READER_1234
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "BufferView.h"
+
+/// A cursor for parsing a range of bytes. Reading past the end doesn't crash or return
+/// partial values: it sets a sticky error flag, after which every read returns 0 or an empty view.
+/// This means a frame can be parsed field by field and checked once, with `isValid()`, at the end.
+/// Never allocates.
+class ByteReader {
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _offset = 0;
+    bool _hasError = false;
+
+    /// returns true if `length` more bytes can be read, otherwise marks the reader as failed
+    bool canRead(size_t length) {
+        if(length <= _size - _offset) return true;
+        fail();
+        return false;
+    }
+
+public:
+    explicit ByteReader(const BufferView& view) : _data(view.data()), _size(view.size()) {}
+
+    // MARK: - State
+    bool isValid() const { return !_hasError; }
+    bool hasError() const { return _hasError; }
+    size_t offset() const { return _offset; }
+    size_t remaining() const { return _size - _offset; }
+    bool isAtEnd() const { return _offset == _size; }
+
+    /// marks the reader as failed: all subsequent reads return 0
+    void fail() {
+        _hasError = true;
+        _offset = _size;
+    }
+
+    // MARK: - Reading
+    uint8_t readUint8() {
+        if(!canRead(1)) return 0;
+        return _data[_offset++];
+    }
+
+    uint16_t readBigEndianUint16() {
+        if(!canRead(2)) return 0;
+        const uint8_t* bytes = _data + _offset;
+        _offset += 2;
+        return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+    }
+
+    uint32_t readBigEndianUint32() {
+        if(!canRead(4)) return 0;
+        const uint8_t* bytes = _data + _offset;
+        _offset += 4;
+        return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+    }
+
+    uint16_t readLittleEndianUint16() {
+        if(!canRead(2)) return 0;
+        const uint8_t* bytes = _data + _offset;
+        _offset += 2;
+        return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+    }
+
+    uint32_t readLittleEndianUint32() {
+        if(!canRead(4)) return 0;
+        const uint8_t* bytes = _data + _offset;
+        _offset += 4;
+        return bytes[0] | (static_cast<uint32_t>(bytes[1]) << 8) | (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    }
+
+    /// the most bytes a packed 32 bit int takes: 5 times 7 bits
+    static const size_t maximumPackedIntLength = 5;
+
+    /// reads an int packed with `Buffer::appendPackedInt()`: 7 bits per byte, high bit set if more bytes follow.
+    /// Fails if the value isn't terminated within `maximumNumberOfBytes` bytes or doesn't fit in 32 bits.
+    /// `maximumNumberOfBytes` is capped at `maximumPackedIntLength`, longer values never fit.
+    uint32_t readPackedInt(size_t maximumNumberOfBytes = maximumPackedIntLength) {
+        if(maximumNumberOfBytes > maximumPackedIntLength) maximumNumberOfBytes = maximumPackedIntLength;
+
+        uint32_t value = 0;
+        for(size_t index = 0; index < maximumNumberOfBytes; index++) {
+            if(!canRead(1)) return 0;
+            uint8_t byte = _data[_offset++];
+            if(index == 4 && (byte & 0xF0) != 0) break; // more than 32 bits
+            value |= static_cast<uint32_t>(byte & 0x7F) << (index * 7);
+            if((byte & 0x80) == 0) return value;
+        }
+
+        fail();
+        return 0;
+    }
+
+    /// reads `length` bytes as a view on the underlying data
+    BufferView readBuffer(size_t length) {
+        if(!canRead(length)) return BufferView();
+        BufferView result(_data + _offset, length);
+        _offset += length;
+        return result;
+    }
+
+    /// reads all remaining bytes
+    BufferView readRemaining() {
+        return readBuffer(remaining());
+    }
+
+    void skip(size_t length) {
+        if(canRead(length)) _offset += length;
+    }
+};
+
+#endif//BYTE_READER_1234
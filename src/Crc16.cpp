@@ -0,0 +1,109 @@
+#include "Crc16.h"
+
+#define TUYA_BLE_CRC16_ENTRY(slice, index) Crc16::tableEntry(slice, index)
+#define TUYA_BLE_CRC16_ROW(slice, base) \
+    TUYA_BLE_CRC16_ENTRY(slice, base + 0), TUYA_BLE_CRC16_ENTRY(slice, base + 1), TUYA_BLE_CRC16_ENTRY(slice, base + 2), TUYA_BLE_CRC16_ENTRY(slice, base + 3), \
+    TUYA_BLE_CRC16_ENTRY(slice, base + 4), TUYA_BLE_CRC16_ENTRY(slice, base + 5), TUYA_BLE_CRC16_ENTRY(slice, base + 6), TUYA_BLE_CRC16_ENTRY(slice, base + 7), \
+    TUYA_BLE_CRC16_ENTRY(slice, base + 8), TUYA_BLE_CRC16_ENTRY(slice, base + 9), TUYA_BLE_CRC16_ENTRY(slice, base + 10), TUYA_BLE_CRC16_ENTRY(slice, base + 11), \
+    TUYA_BLE_CRC16_ENTRY(slice, base + 12), TUYA_BLE_CRC16_ENTRY(slice, base + 13), TUYA_BLE_CRC16_ENTRY(slice, base + 14), TUYA_BLE_CRC16_ENTRY(slice, base + 15)
+#define TUYA_BLE_CRC16_TABLE(slice) { \
+    TUYA_BLE_CRC16_ROW(slice, 0), \
+    TUYA_BLE_CRC16_ROW(slice, 16), \
+    TUYA_BLE_CRC16_ROW(slice, 32), \
+    TUYA_BLE_CRC16_ROW(slice, 48), \
+    TUYA_BLE_CRC16_ROW(slice, 64), \
+    TUYA_BLE_CRC16_ROW(slice, 80), \
+    TUYA_BLE_CRC16_ROW(slice, 96), \
+    TUYA_BLE_CRC16_ROW(slice, 112), \
+    TUYA_BLE_CRC16_ROW(slice, 128), \
+    TUYA_BLE_CRC16_ROW(slice, 144), \
+    TUYA_BLE_CRC16_ROW(slice, 160), \
+    TUYA_BLE_CRC16_ROW(slice, 176), \
+    TUYA_BLE_CRC16_ROW(slice, 192), \
+    TUYA_BLE_CRC16_ROW(slice, 208), \
+    TUYA_BLE_CRC16_ROW(slice, 224), \
+    TUYA_BLE_CRC16_ROW(slice, 240), \
+}
+
+// the tables are computed by the compiler and end up in flash
+constexpr uint16_t Crc16::table[Crc16::numberOfSlices][256] = {
+    TUYA_BLE_CRC16_TABLE(0),
+    TUYA_BLE_CRC16_TABLE(1),
+    TUYA_BLE_CRC16_TABLE(2),
+    TUYA_BLE_CRC16_TABLE(3),
+};
+
+static_assert(Crc16::table[0][1] == 0xC0C1 && Crc16::table[0][255] == 0x4040, "CRC-16/MODBUS table mismatch");
+
+#undef TUYA_BLE_CRC16_TABLE
+#undef TUYA_BLE_CRC16_ROW
+#undef TUYA_BLE_CRC16_ENTRY
+
+uint16_t Crc16::updateSliceBy4(uint16_t crc, const uint8_t* data, size_t length) {
+    while(length >= 4) {
+        // the first two bytes overlap with the crc register, the last two are just shifted through
+        crc ^= static_cast<uint16_t>(data[0] | (data[1] << 8));
+        crc = table[3][crc & 0xFF] ^ table[2][crc >> 8] ^ table[1][data[2]] ^ table[0][data[3]];
+        data += 4;
+        length -= 4;
+    }
+
+    while(length > 0) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xFF];
+        data++;
+        length--;
+    }
+
+    return crc;
+}
+
+uint16_t Crc16::copyAndUpdateSliceBy4(uint16_t crc, uint8_t* destination, const uint8_t* source, size_t length) {
+    // the same as `updateSliceBy4()`, every byte that's read is also written
+    while(length >= 4) {
+        uint8_t b0 = source[0], b1 = source[1], b2 = source[2], b3 = source[3];
+        destination[0] = b0;
+        destination[1] = b1;
+        destination[2] = b2;
+        destination[3] = b3;
+        crc ^= static_cast<uint16_t>(b0 | (b1 << 8));
+        crc = table[3][crc & 0xFF] ^ table[2][crc >> 8] ^ table[1][b2] ^ table[0][b3];
+        source += 4;
+        destination += 4;
+        length -= 4;
+    }
+
+    while(length > 0) {
+        *destination = *source;
+        crc = (crc >> 8) ^ table[0][(crc ^ *source) & 0xFF];
+        source++;
+        destination++;
+        length--;
+    }
+
+    return crc;
+}
+
+uint16_t Crc16::computeBytewise(const uint8_t* data, size_t length) {
+    uint16_t crc = seed;
+    for(size_t i = 0; i < length; i++) {
+        crc = (crc >> 8) ^ table[0][(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+uint16_t Crc16::computeBitwise(const uint8_t* data, size_t length) {
+    uint16_t crc = seed;
+    for(size_t i = 0; i < length; i++) {
+        crc ^= static_cast<uint16_t>(data[i]);
+
+        for(size_t b = 0; b < 8; b++) {
+            uint16_t tmp = crc & 0x1;
+            crc >>= 1;
+            if(tmp != 0) {
+                crc ^= polynomial;
+            }
+        }
+    }
+
+    return crc;
+}
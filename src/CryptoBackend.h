@@ -0,0 +1,68 @@
+#ifndef CRYPTO_BACKEND_1234
+#define CRYPTO_BACKEND_1234
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// The primitives below CryptoHelper (AES-CBC and MD5) come from one of these backends, chosen at compile time
+/// by defining TUYA_BLE_CRYPTO_BACKEND, e.g. with `build_flags = -DTUYA_BLE_CRYPTO_BACKEND=TUYA_BLE_CRYPTO_BACKEND_MBEDTLS`:
+///  - SOFTWARE: the CryptoAES_CBC library and Arduino's MD5Builder (default on Arduino)
+///  - MBEDTLS: mbedtls, which ESP-IDF routes to the AES accelerator on chips that have one
+///  - REFERENCE: portable C++ implementations without dependencies, for host builds (default elsewhere)
+#define TUYA_BLE_CRYPTO_BACKEND_SOFTWARE 1
+#define TUYA_BLE_CRYPTO_BACKEND_MBEDTLS 2
+#define TUYA_BLE_CRYPTO_BACKEND_REFERENCE 3
+
+#ifndef TUYA_BLE_CRYPTO_BACKEND
+    #if defined(ARDUINO)
+        #define TUYA_BLE_CRYPTO_BACKEND TUYA_BLE_CRYPTO_BACKEND_SOFTWARE
+    #else
+        #define TUYA_BLE_CRYPTO_BACKEND TUYA_BLE_CRYPTO_BACKEND_REFERENCE
+    #endif
+#endif
+
+#if TUYA_BLE_CRYPTO_BACKEND == TUYA_BLE_CRYPTO_BACKEND_SOFTWARE
+    #include <AES.h>
+
+    /// an expanded AES-128 key
+    struct CryptoBackendAes128Key {
+        AES128 cipher;
+    };
+#elif TUYA_BLE_CRYPTO_BACKEND == TUYA_BLE_CRYPTO_BACKEND_MBEDTLS
+    #include "mbedtls/aes.h"
+
+    /// an expanded AES-128 key, mbedtls needs different schedules for encrypting and decrypting
+    struct CryptoBackendAes128Key {
+        mbedtls_aes_context encryption;
+        mbedtls_aes_context decryption;
+    };
+#elif TUYA_BLE_CRYPTO_BACKEND == TUYA_BLE_CRYPTO_BACKEND_REFERENCE
+    /// an expanded AES-128 key
+    struct CryptoBackendAes128Key {
+        uint8_t roundKeys[176];
+    };
+#else
+    #error "Unknown TUYA_BLE_CRYPTO_BACKEND"
+#endif
+
+class CryptoBackend {
+public:
+    /// name of the backend, for logging
+    static const char* name();
+
+    // hashing
+    static void md5(const uint8_t* data, size_t length, uint8_t digest[16]);
+
+    // aes-128 cbc with an expanded key, `length` must be a multiple of 16.
+    static void aesCbc128Initialize(CryptoBackendAes128Key& key);
+    static void aesCbc128SetKey(CryptoBackendAes128Key& key, const uint8_t* keyBytes);
+    static void aesCbc128Clear(CryptoBackendAes128Key& key);
+    static void aesCbc128Encrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length);
+    static void aesCbc128Decrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length);
+
+    // one-shot aes-256 cbc with a 32 byte key, `length` must be a multiple of 16.
+    static void aesCbc256Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length);
+    static void aesCbc256Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length);
+};
+
+#endif//CRYPTO_BACKEND_1234
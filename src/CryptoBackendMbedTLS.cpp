@@ -0,0 +1,71 @@
+#include "CryptoBackend.h"
+
+#if TUYA_BLE_CRYPTO_BACKEND == TUYA_BLE_CRYPTO_BACKEND_MBEDTLS
+
+#include <string.h>
+#include "mbedtls/aes.h"
+#include "mbedtls/md5.h"
+#include "mbedtls/version.h"
+
+const char* CryptoBackend::name() {
+    return "mbedtls";
+}
+
+void CryptoBackend::md5(const uint8_t* data, size_t length, uint8_t digest[16]) {
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+    mbedtls_md5(data, length, digest);
+#else
+    mbedtls_md5_ret(data, length, digest);
+#endif
+}
+
+void CryptoBackend::aesCbc128Initialize(CryptoBackendAes128Key& key) {
+    mbedtls_aes_init(&key.encryption);
+    mbedtls_aes_init(&key.decryption);
+}
+
+void CryptoBackend::aesCbc128SetKey(CryptoBackendAes128Key& key, const uint8_t* keyBytes) {
+    mbedtls_aes_setkey_enc(&key.encryption, keyBytes, 128);
+    mbedtls_aes_setkey_dec(&key.decryption, keyBytes, 128);
+}
+
+void CryptoBackend::aesCbc128Clear(CryptoBackendAes128Key& key) {
+    mbedtls_aes_free(&key.encryption);
+    mbedtls_aes_free(&key.decryption);
+    aesCbc128Initialize(key);
+}
+
+void CryptoBackend::aesCbc128Encrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length) {
+    // mbedtls updates the iv it's given, so it gets a copy
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+    mbedtls_aes_crypt_cbc(&key.encryption, MBEDTLS_AES_ENCRYPT, length & ~size_t(15), chain, plainText, output);
+}
+
+void CryptoBackend::aesCbc128Decrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length) {
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+    mbedtls_aes_crypt_cbc(&key.decryption, MBEDTLS_AES_DECRYPT, length & ~size_t(15), chain, cipherText, output);
+}
+
+void CryptoBackend::aesCbc256Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length) {
+    mbedtls_aes_context context;
+    mbedtls_aes_init(&context);
+    mbedtls_aes_setkey_enc(&context, key, 256);
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+    mbedtls_aes_crypt_cbc(&context, MBEDTLS_AES_ENCRYPT, length & ~size_t(15), chain, plainText, output);
+    mbedtls_aes_free(&context);
+}
+
+void CryptoBackend::aesCbc256Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length) {
+    mbedtls_aes_context context;
+    mbedtls_aes_init(&context);
+    mbedtls_aes_setkey_dec(&context, key, 256);
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+    mbedtls_aes_crypt_cbc(&context, MBEDTLS_AES_DECRYPT, length & ~size_t(15), chain, cipherText, output);
+    mbedtls_aes_free(&context);
+}
+
+#endif
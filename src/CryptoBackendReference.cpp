@@ -0,0 +1,301 @@
+#include "CryptoBackend.h"
+
+#if TUYA_BLE_CRYPTO_BACKEND == TUYA_BLE_CRYPTO_BACKEND_REFERENCE
+
+#include <string.h>
+
+// A straightforward, byte-oriented implementation of AES (FIPS-197) and MD5 (RFC 1321).
+// It's not constant-time and not fast, but it has no dependencies, so it builds anywhere.
+
+static const uint8_t sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static const uint8_t inverseSbox[256] = {
+    0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
+    0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
+    0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
+    0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
+    0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
+    0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
+    0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
+    0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
+    0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
+    0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
+    0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
+    0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
+    0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
+    0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
+    0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
+    0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d,
+};
+
+// MARK: - AES
+
+static uint8_t multiplyByTwo(uint8_t value) {
+    return static_cast<uint8_t>((value << 1) ^ ((value & 0x80) ? 0x1b : 0x00));
+}
+
+static uint8_t multiply(uint8_t value, uint8_t factor) {
+    uint8_t result = 0;
+    while(factor != 0) {
+        if(factor & 1) result ^= value;
+        value = multiplyByTwo(value);
+        factor >>= 1;
+    }
+    return result;
+}
+
+/// expands a key of `keyWords` 32-bit words into `(rounds + 1) * 16` bytes of round keys
+static void expandKey(const uint8_t* key, size_t keyWords, size_t rounds, uint8_t* roundKeys) {
+    memcpy(roundKeys, key, keyWords * 4);
+
+    uint8_t roundConstant = 0x01;
+    for(size_t word = keyWords; word < 4 * (rounds + 1); word++) {
+        uint8_t temp[4];
+        memcpy(temp, roundKeys + (word - 1) * 4, 4);
+
+        if(word % keyWords == 0) {
+            uint8_t first = temp[0];
+            temp[0] = sbox[temp[1]] ^ roundConstant;
+            temp[1] = sbox[temp[2]];
+            temp[2] = sbox[temp[3]];
+            temp[3] = sbox[first];
+            roundConstant = multiplyByTwo(roundConstant);
+        } else if(keyWords > 6 && word % keyWords == 4) {
+            for(size_t i = 0; i < 4; i++) temp[i] = sbox[temp[i]];
+        }
+
+        for(size_t i = 0; i < 4; i++) {
+            roundKeys[word * 4 + i] = roundKeys[(word - keyWords) * 4 + i] ^ temp[i];
+        }
+    }
+}
+
+static void addRoundKey(uint8_t* state, const uint8_t* roundKey) {
+    for(size_t i = 0; i < 16; i++) state[i] ^= roundKey[i];
+}
+
+static void encryptBlock(const uint8_t* roundKeys, size_t rounds, uint8_t* state) {
+    addRoundKey(state, roundKeys);
+    for(size_t round = 1; round <= rounds; round++) {
+        // sub bytes + shift rows: the state is column-major, row r shifts left by r
+        uint8_t shifted[16];
+        for(size_t column = 0; column < 4; column++) {
+            for(size_t row = 0; row < 4; row++) {
+                shifted[column * 4 + row] = sbox[state[((column + row) % 4) * 4 + row]];
+            }
+        }
+
+        if(round != rounds) {
+            // mix columns
+            for(size_t column = 0; column < 4; column++) {
+                uint8_t* c = shifted + column * 4;
+                uint8_t a0 = c[0], a1 = c[1], a2 = c[2], a3 = c[3];
+                state[column * 4 + 0] = multiplyByTwo(a0) ^ (multiplyByTwo(a1) ^ a1) ^ a2 ^ a3;
+                state[column * 4 + 1] = a0 ^ multiplyByTwo(a1) ^ (multiplyByTwo(a2) ^ a2) ^ a3;
+                state[column * 4 + 2] = a0 ^ a1 ^ multiplyByTwo(a2) ^ (multiplyByTwo(a3) ^ a3);
+                state[column * 4 + 3] = (multiplyByTwo(a0) ^ a0) ^ a1 ^ a2 ^ multiplyByTwo(a3);
+            }
+        } else {
+            memcpy(state, shifted, 16);
+        }
+
+        addRoundKey(state, roundKeys + round * 16);
+    }
+}
+
+static void decryptBlock(const uint8_t* roundKeys, size_t rounds, uint8_t* state) {
+    addRoundKey(state, roundKeys + rounds * 16);
+    for(size_t round = rounds; round >= 1; round--) {
+        // inverse shift rows + inverse sub bytes: row r shifts right by r
+        uint8_t shifted[16];
+        for(size_t column = 0; column < 4; column++) {
+            for(size_t row = 0; row < 4; row++) {
+                shifted[((column + row) % 4) * 4 + row] = inverseSbox[state[column * 4 + row]];
+            }
+        }
+
+        addRoundKey(shifted, roundKeys + (round - 1) * 16);
+
+        if(round != 1) {
+            // inverse mix columns
+            for(size_t column = 0; column < 4; column++) {
+                uint8_t* c = shifted + column * 4;
+                uint8_t a0 = c[0], a1 = c[1], a2 = c[2], a3 = c[3];
+                state[column * 4 + 0] = multiply(a0, 14) ^ multiply(a1, 11) ^ multiply(a2, 13) ^ multiply(a3, 9);
+                state[column * 4 + 1] = multiply(a0, 9) ^ multiply(a1, 14) ^ multiply(a2, 11) ^ multiply(a3, 13);
+                state[column * 4 + 2] = multiply(a0, 13) ^ multiply(a1, 9) ^ multiply(a2, 14) ^ multiply(a3, 11);
+                state[column * 4 + 3] = multiply(a0, 11) ^ multiply(a1, 13) ^ multiply(a2, 9) ^ multiply(a3, 14);
+            }
+        } else {
+            memcpy(state, shifted, 16);
+        }
+    }
+}
+
+static void cbcEncrypt(const uint8_t* roundKeys, size_t rounds, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length) {
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+    for(size_t position = 0; position + 16 <= length; position += 16) {
+        for(size_t i = 0; i < 16; i++) chain[i] ^= plainText[position + i];
+        encryptBlock(roundKeys, rounds, chain);
+        memcpy(output + position, chain, 16);
+    }
+}
+
+static void cbcDecrypt(const uint8_t* roundKeys, size_t rounds, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length) {
+    // we keep a copy of the cipher text blocks, so decrypting in place works
+    uint8_t chain[16];
+    uint8_t block[16];
+    uint8_t nextChain[16];
+    memcpy(chain, iv, 16);
+    for(size_t position = 0; position + 16 <= length; position += 16) {
+        memcpy(nextChain, cipherText + position, 16);
+        memcpy(block, nextChain, 16);
+        decryptBlock(roundKeys, rounds, block);
+        for(size_t i = 0; i < 16; i++) output[position + i] = block[i] ^ chain[i];
+        memcpy(chain, nextChain, 16);
+    }
+}
+
+// MARK: - MD5
+
+static const uint32_t md5Constants[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const uint8_t md5Shifts[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static void md5Block(uint32_t* hash, const uint8_t* block) {
+    uint32_t words[16];
+    for(size_t i = 0; i < 16; i++) {
+        words[i] = block[i * 4] | (static_cast<uint32_t>(block[i * 4 + 1]) << 8) | (static_cast<uint32_t>(block[i * 4 + 2]) << 16) | (static_cast<uint32_t>(block[i * 4 + 3]) << 24);
+    }
+
+    uint32_t a = hash[0], b = hash[1], c = hash[2], d = hash[3];
+    for(size_t i = 0; i < 64; i++) {
+        uint32_t f;
+        size_t g;
+        if(i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if(i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        } else if(i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+
+        uint32_t rotated = a + f + md5Constants[i] + words[g];
+        a = d;
+        d = c;
+        c = b;
+        b = b + ((rotated << md5Shifts[i]) | (rotated >> (32 - md5Shifts[i])));
+    }
+
+    hash[0] += a;
+    hash[1] += b;
+    hash[2] += c;
+    hash[3] += d;
+}
+
+// MARK: - Backend
+
+const char* CryptoBackend::name() {
+    return "reference";
+}
+
+void CryptoBackend::md5(const uint8_t* data, size_t length, uint8_t digest[16]) {
+    uint32_t hash[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+    size_t position = 0;
+    for(; position + 64 <= length; position += 64) {
+        md5Block(hash, data + position);
+    }
+
+    // the final block(s): remaining bytes, 0x80, zero padding and the length in bits
+    uint8_t tail[128] = {0};
+    size_t remaining = length - position;
+    if(remaining > 0) {
+        memcpy(tail, data + position, remaining);
+    }
+    tail[remaining] = 0x80;
+    size_t tailLength = remaining + 9 <= 64 ? 64 : 128;
+    uint64_t bitLength = static_cast<uint64_t>(length) * 8;
+    for(size_t i = 0; i < 8; i++) {
+        tail[tailLength - 8 + i] = static_cast<uint8_t>(bitLength >> (i * 8));
+    }
+    for(size_t offset = 0; offset < tailLength; offset += 64) {
+        md5Block(hash, tail + offset);
+    }
+
+    for(size_t i = 0; i < 16; i++) {
+        digest[i] = static_cast<uint8_t>(hash[i / 4] >> ((i % 4) * 8));
+    }
+}
+
+void CryptoBackend::aesCbc128Initialize(CryptoBackendAes128Key& key) {
+    memset(key.roundKeys, 0, sizeof(key.roundKeys));
+}
+
+void CryptoBackend::aesCbc128SetKey(CryptoBackendAes128Key& key, const uint8_t* keyBytes) {
+    expandKey(keyBytes, 4, 10, key.roundKeys);
+}
+
+void CryptoBackend::aesCbc128Clear(CryptoBackendAes128Key& key) {
+    memset(key.roundKeys, 0, sizeof(key.roundKeys));
+}
+
+void CryptoBackend::aesCbc128Encrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length) {
+    cbcEncrypt(key.roundKeys, 10, iv, plainText, output, length);
+}
+
+void CryptoBackend::aesCbc128Decrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length) {
+    cbcDecrypt(key.roundKeys, 10, iv, cipherText, output, length);
+}
+
+void CryptoBackend::aesCbc256Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length) {
+    uint8_t roundKeys[240];
+    expandKey(key, 8, 14, roundKeys);
+    cbcEncrypt(roundKeys, 14, iv, plainText, output, length);
+}
+
+void CryptoBackend::aesCbc256Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length) {
+    uint8_t roundKeys[240];
+    expandKey(key, 8, 14, roundKeys);
+    cbcDecrypt(roundKeys, 14, iv, cipherText, output, length);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "CryptoBackend.h"
+
+#if TUYA_BLE_CRYPTO_BACKEND == TUYA_BLE_CRYPTO_BACKEND_SOFTWARE
+
+#include <Arduino.h>
+#include <MD5Builder.h>
+#include <CryptoAES_CBC.h>
+#include <AES.h>
+#include <CBC.h>
+
+const char* CryptoBackend::name() {
+    return "software";
+}
+
+void CryptoBackend::md5(const uint8_t* data, size_t length, uint8_t digest[16]) {
+    MD5Builder md5builder;
+    md5builder.begin();
+    md5builder.add(const_cast<uint8_t*>(data), static_cast<uint16_t>(length));
+    md5builder.calculate();
+    md5builder.getBytes(digest);
+}
+
+void CryptoBackend::aesCbc128Initialize(CryptoBackendAes128Key&) {
+    // the cipher expands the key in setKey(), there's nothing to precompute
+}
+
+void CryptoBackend::aesCbc128SetKey(CryptoBackendAes128Key& key, const uint8_t* keyBytes) {
+    key.cipher.setKey(keyBytes, 16);
+}
+
+void CryptoBackend::aesCbc128Clear(CryptoBackendAes128Key& key) {
+    key.cipher.clear();
+}
+
+void CryptoBackend::aesCbc128Encrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length) {
+    // cbc: every plain text block is xor'ed with the previous cipher text block (or the iv) before encrypting
+    uint8_t chain[16];
+    memcpy(chain, iv, 16);
+    for(size_t position = 0; position + 16 <= length; position += 16) {
+        for(size_t i = 0; i < 16; i++) {
+            chain[i] ^= plainText[position + i];
+        }
+        key.cipher.encryptBlock(output + position, chain);
+        memcpy(chain, output + position, 16);
+    }
+}
+
+void CryptoBackend::aesCbc128Decrypt(CryptoBackendAes128Key& key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length) {
+    // we keep a copy of the cipher text blocks, so decrypting in place works
+    uint8_t chain[16];
+    uint8_t cipherBlock[16];
+    memcpy(chain, iv, 16);
+    for(size_t position = 0; position + 16 <= length; position += 16) {
+        memcpy(cipherBlock, cipherText + position, 16);
+        key.cipher.decryptBlock(output + position, cipherBlock);
+        for(size_t i = 0; i < 16; i++) {
+            output[position + i] ^= chain[i];
+        }
+        memcpy(chain, cipherBlock, 16);
+    }
+}
+
+void CryptoBackend::aesCbc256Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, uint8_t* output, size_t length) {
+    CBC<AES256> cbcaes256;
+    cbcaes256.setIV(iv, 16);
+    cbcaes256.setKey(key, 32);
+    cbcaes256.encrypt(output, plainText, length);
+}
+
+void CryptoBackend::aesCbc256Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, uint8_t* output, size_t length) {
+    CBC<AES256> cbcaes256;
+    cbcaes256.setIV(iv, 16);
+    cbcaes256.setKey(key, 32);
+    cbcaes256.decrypt(output, cipherText, length);
+}
+
+#endif
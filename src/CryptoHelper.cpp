@@ -1,84 +1,81 @@
 #include "CryptoHelper.h"
+#include "Crc16.h"
+#include "RandomPool.h"
 
-#include <MD5Builder.h>
-#include <CryptoAES_CBC.h>
-#include <AES.h>
-#include <CBC.h>
-#include "bootloader_random.h"
+void AesCbc128Key::setKey(const uint8_t* key) {
+    CryptoBackend::aesCbc128SetKey(_key, key);
+    _isSet = true;
+}
 
-static CBC<AES128> cbcaes128;
-static CBC<AES256> cbcaes256;
+void AesCbc128Key::clear() {
+    CryptoBackend::aesCbc128Clear(_key);
+    _isSet = false;
+}
 
-Buffer CryptoHelper::md5(const uint8_t* data, size_t length) {
-    MD5Builder md5builder;
-    md5builder.begin();
-    md5builder.add(const_cast<uint8_t*>(data), static_cast<uint16_t>(length));
-    uint8_t digest[16] = {0};
-    md5builder.calculate();
-    md5builder.getBytes(digest);
+Buffer AesCbc128Key::encrypt(const uint8_t* iv, const uint8_t* plainText, size_t length, BufferArena* arena) const {
+    Buffer output = arena != nullptr ? Buffer(*arena) : Buffer();
+    output.appendRepeated(0, length);
+    encryptInto(iv, plainText, length, output.data());
+    return output;
+}
 
-    return Buffer(digest, sizeof(digest));
+Buffer AesCbc128Key::decrypt(const uint8_t* iv, const uint8_t* cipherText, size_t length, BufferArena* arena) const {
+    Buffer output = arena != nullptr ? Buffer(*arena) : Buffer();
+    output.appendRepeated(0, length);
+    decryptInto(iv, cipherText, length, output.data());
+    return output;
 }
 
-Buffer CryptoHelper::aesCbc128Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, size_t length) {
-    Buffer output(length);
+void AesCbc128Key::encryptInto(const uint8_t* iv, const uint8_t* plainText, size_t length, uint8_t* output) const {
+    CryptoBackend::aesCbc128Encrypt(_key, iv, plainText, output, length);
+}
 
-    cbcaes128.setIV(iv, 16);
-    cbcaes128.setKey(key, 16);
-    cbcaes128.decrypt(output.data(), cipherText, length);
+void AesCbc128Key::decryptInto(const uint8_t* iv, const uint8_t* cipherText, size_t length, uint8_t* output) const {
+    CryptoBackend::aesCbc128Decrypt(_key, iv, cipherText, output, length);
+}
 
-    return output;
+Buffer CryptoHelper::md5(const uint8_t* data, size_t length) {
+    uint8_t digest[16] = {0};
+    CryptoBackend::md5(data, length, digest);
+    return Buffer(digest, sizeof(digest));
 }
 
-Buffer CryptoHelper::aesCbc128Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, size_t length) {
-   Buffer output(length);
+Buffer CryptoHelper::aesCbc128Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, size_t length, BufferArena* arena) {
+    return AesCbc128Key(key).decrypt(iv, cipherText, length, arena);
+}
 
-    cbcaes128.setIV(iv, 16);
-    cbcaes128.setKey(key, 16);
-    cbcaes128.encrypt(output.data(), plainText, length);
+Buffer CryptoHelper::aesCbc128Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, size_t length, BufferArena* arena) {
+    return AesCbc128Key(key).encrypt(iv, plainText, length, arena);
+}
 
-    return output;
+void CryptoHelper::aesCbc128DecryptInPlace(const uint8_t* key, const uint8_t* iv, uint8_t* data, size_t length) {
+    AesCbc128Key(key).decryptInPlace(iv, data, length);
 }
 
-Buffer CryptoHelper::aesCbc256Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, size_t length) {
-   Buffer output(length);
+void CryptoHelper::aesCbc128EncryptInPlace(const uint8_t* key, const uint8_t* iv, uint8_t* data, size_t length) {
+    AesCbc128Key(key).encryptInPlace(iv, data, length);
+}
 
-    cbcaes256.setIV(iv, 16);
-    cbcaes256.setKey(key, 16);
-    cbcaes256.encrypt(output.data(), plainText, length);
+Buffer CryptoHelper::aesCbc256Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, size_t length) {
+    Buffer output(length);
+    CryptoBackend::aesCbc256Encrypt(key, iv, plainText, output.data(), length);
 
     return output;
 }
 
 Buffer CryptoHelper::aesCbc256Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, size_t length) {
-   Buffer output(length);
-
-    cbcaes256.setIV(iv, 16);
-    cbcaes256.setKey(key, 16);
-    cbcaes256.decrypt(output.data(), cipherText, length);
+    Buffer output(length);
+    CryptoBackend::aesCbc256Decrypt(key, iv, cipherText, output.data(), length);
 
     return output;
 }
 
 Buffer CryptoHelper::iv(size_t length) {
     Buffer output(length);
-    esp_fill_random(output.data(), length);
+    RandomPool::fillWithEntropy(output.data(), length);
     return output;
 }
 
 uint16_t CryptoHelper::crc16(const uint8_t* data, size_t length) {
-    uint16_t crc = 0xFFFF;
-    for(size_t i = 0; i < length; i++) {
-        crc ^= static_cast<uint16_t>(data[i]);
-
-        for(size_t b = 0; b < 8; b++) {
-            uint16_t tmp = crc & 0x1;
-            crc >>= 1;
-            if(tmp != 0) {
-                crc ^= 0xA001;
-            }
-        }
-    }
-
-    return crc;
+    return Crc16::compute(data, length);
 }
\ No newline at end of file
@@ -3,14 +3,54 @@
 
 #include "Buffer.h"
 
+#include "CryptoBackend.h"
+
+/// An AES-128 key with its key schedule expanded once, used for CBC encryption and decryption.
+/// The CBC chaining state lives on the stack of each call, so a key can be shared by
+/// the task that sends and the task that receives without the two interfering.
+class AesCbc128Key {
+private:
+    // the backend functions aren't const, but only read the expanded key schedule
+    mutable CryptoBackendAes128Key _key;
+    bool _isSet = false;
+
+    AesCbc128Key(const AesCbc128Key&) = delete;
+    AesCbc128Key& operator=(const AesCbc128Key&) = delete;
+
+public:
+    AesCbc128Key() { CryptoBackend::aesCbc128Initialize(_key); }
+    explicit AesCbc128Key(const uint8_t* key) : AesCbc128Key() { setKey(key); }
+    ~AesCbc128Key() { clear(); }
+
+    /// sets a 16 byte key and expands its key schedule
+    void setKey(const uint8_t* key);
+    void clear();
+    bool isSet() const { return _isSet; }
+
+    // when `arena` is set, the output is allocated in that arena
+    Buffer encrypt(const uint8_t* iv, const uint8_t* plainText, size_t length, BufferArena* arena = nullptr) const;
+    Buffer decrypt(const uint8_t* iv, const uint8_t* cipherText, size_t length, BufferArena* arena = nullptr) const;
+
+    // writes the output to `output`, which must have room for `length` bytes and may be the same as the input
+    void encryptInto(const uint8_t* iv, const uint8_t* plainText, size_t length, uint8_t* output) const;
+    void decryptInto(const uint8_t* iv, const uint8_t* cipherText, size_t length, uint8_t* output) const;
+
+    // replaces `data` by its encrypted or decrypted version, without allocating
+    void encryptInPlace(const uint8_t* iv, uint8_t* data, size_t length) const { encryptInto(iv, data, length, data); }
+    void decryptInPlace(const uint8_t* iv, uint8_t* data, size_t length) const { decryptInto(iv, data, length, data); }
+};
+
 class CryptoHelper {
 public:
     // hashing
     static Buffer md5(const uint8_t* data, size_t length);
 
     // aes cbc encryption
-    static Buffer aesCbc128Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, size_t length);
-    static Buffer aesCbc128Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, size_t length);
+    // when `arena` is set, the output is allocated in that arena
+    static Buffer aesCbc128Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, size_t length, BufferArena* arena = nullptr);
+    static Buffer aesCbc128Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, size_t length, BufferArena* arena = nullptr);
+    static void aesCbc128DecryptInPlace(const uint8_t* key, const uint8_t* iv, uint8_t* data, size_t length);
+    static void aesCbc128EncryptInPlace(const uint8_t* key, const uint8_t* iv, uint8_t* data, size_t length);
     static Buffer aesCbc256Encrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* plainText, size_t length);
     static Buffer aesCbc256Decrypt(const uint8_t* key, const uint8_t* iv, const uint8_t* cipherText, size_t length);
 
@@ -0,0 +1,72 @@
+#include "RandomPool.h"
+
+#include <string.h>
+
+/// splitmix64: small, fast and good enough to generate reproducible test data, not for production keys
+static uint64_t nextSplitMix64(uint64_t& state) {
+    uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+static void fillSplitMix64(uint64_t& state, uint8_t* output, size_t length) {
+    while(length > 0) {
+        uint64_t value = nextSplitMix64(state);
+        size_t count = length < sizeof(value) ? length : sizeof(value);
+        for(size_t index = 0; index < count; index++) {
+            output[index] = static_cast<uint8_t>(value >> (index * 8));
+        }
+        output += count;
+        length -= count;
+    }
+}
+
+RandomPool::RandomPool() {
+#if !defined(ARDUINO)
+    seed(defaultSeed);
+#endif
+}
+
+void RandomPool::seed(uint64_t seed) {
+    _isSeeded = true;
+    _state = seed;
+    _offset = capacity;
+}
+
+void RandomPool::generate(uint8_t* output, size_t length) {
+    if(_isSeeded) {
+        fillSplitMix64(_state, output, length);
+    } else {
+        fillWithEntropy(output, length);
+    }
+}
+
+void RandomPool::refill() {
+    generate(_bytes, capacity);
+    _offset = 0;
+}
+
+void RandomPool::fill(uint8_t* output, size_t length) {
+    while(length > 0) {
+        if(_offset == capacity) refill();
+
+        size_t count = available() < length ? available() : length;
+        memcpy(output, _bytes + _offset, count);
+
+        // bytes are handed out once, so we don't leave them behind in the pool
+        memset(_bytes + _offset, 0, count);
+        _offset += count;
+        output += count;
+        length -= count;
+    }
+}
+
+void RandomPool::fillWithEntropy(uint8_t* output, size_t length) {
+#if defined(ARDUINO)
+    esp_fill_random(output, length);
+#else
+    static uint64_t state = defaultSeed;
+    fillSplitMix64(state, output, length);
+#endif
+}
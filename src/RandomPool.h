@@ -0,0 +1,52 @@
+#ifndef RANDOM_POOL_1234
+#define RANDOM_POOL_1234
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/// A pool of random bytes that is filled in bulk, so that taking an IV for a message
+/// is a copy out of the pool instead of a call into the random number generator.
+/// Refill it when idle with `refillIfBelow()`; when it runs dry while taking bytes, it refills itself.
+///
+/// By default the bytes come from the hardware random number generator. After `seed()`, they come from a
+/// deterministic generator instead, so benchmarks and replay tests produce the same ciphertext on every run.
+/// Host builds (without ARDUINO) have no hardware generator and are always seeded, with `defaultSeed` unless told otherwise.
+///
+/// Not thread safe: use one pool per task, e.g. one per device.
+class RandomPool {
+public:
+    static const size_t capacity = 256;
+    static const uint64_t defaultSeed = 0x54757961424C4500ULL;
+
+private:
+    uint8_t _bytes[capacity];
+    size_t _offset = capacity;
+    bool _isSeeded = false;
+    uint64_t _state = 0;
+
+    void generate(uint8_t* output, size_t length);
+
+public:
+    RandomPool();
+    explicit RandomPool(uint64_t seed) { this->seed(seed); }
+
+    /// switches to the deterministic generator, starting at `seed`, and drops the bytes in the pool
+    void seed(uint64_t seed);
+    bool isDeterministic() const { return _isSeeded; }
+
+    /// number of bytes that can be taken before the pool refills itself
+    size_t available() const { return capacity - _offset; }
+
+    /// replaces the contents of the pool by fresh random bytes
+    void refill();
+    void refillIfBelow(size_t threshold) { if(available() < threshold) refill(); }
+
+    /// copies `length` random bytes into `output`, without allocating
+    void fill(uint8_t* output, size_t length);
+
+    /// fills `output` directly from the shared source: hardware random, or a seeded generator on the host
+    static void fillWithEntropy(uint8_t* output, size_t length);
+};
+
+#endif//RANDOM_POOL_1234
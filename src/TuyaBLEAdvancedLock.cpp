@@ -28,5 +28,5 @@ void TuyaBLEAdvancedLock::lockUnlock(uint8_t memberId, bool shouldLock, std::fun
     data.append(0x00); // mobile phone
     data.append(memberId);
 
-    sendDataPoint(TuyaDataPoint::raw(dpLockUnlock, data), callback);
+    sendDataPoint(Schema::make<LockUnlock>(data), callback);
 }
\ No newline at end of file
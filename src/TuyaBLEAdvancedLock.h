@@ -2,12 +2,17 @@
 #define TUYA_BLE_ADVANCED_LOCK_123
 
 #include "TuyaBLEDevice.h"
+#include "TuyaDataPointSchema.h"
 #include <time.h>
 
 class TuyaBLEAdvancedLock: public TuyaBLEDevice {
 public:
-    static const uint8_t dpUnlockStatus = 47; // [receive] bool, true = unlocked, false = locked
-    static const uint8_t dpLockUnlock = 71; // [send] raw
+    typedef TuyaDP<47, bool, TuyaDPDirection::receive> UnlockStatus; // true = unlocked, false = locked
+    typedef TuyaDP<71, TuyaDPRaw, TuyaDPDirection::send> LockUnlock;
+    typedef TuyaDPSchema<UnlockStatus, LockUnlock> Schema;
+
+    static const uint8_t dpUnlockStatus = UnlockStatus::id;
+    static const uint8_t dpLockUnlock = LockUnlock::id;
 
     // get these from the tuya API: dp 71 returns a base64 encoded binary string:
     // tuya api value: "AAH//zE2MTgzNjM0AWVCKTMAAA==="
@@ -29,7 +34,9 @@ public:
     /// sets the needed values from an API value
     void setFromTuyaDP71Base64EncodedValue(const String& base64EncodedValue);
 
-    bool isLocked() const { return reportedBooleanDataPoint(dpUnlockStatus, false); }
+    const Schema& schema() const { return _schema; }
+
+    bool isLocked() const { return !_schema.get<UnlockStatus>(true); }
 
     void unlock(uint8_t memberId = 1, std::function<void(TuyaBLEDevice*)> callback = nullptr) {
         lockUnlock(memberId, false, callback);
@@ -39,8 +46,12 @@ public:
         lockUnlock(memberId, true, callback);
     }
 
+protected:
+    TuyaDPDecodeResult decodeReportedDataPoint(const TuyaDataPoint& dataPoint) override { return _schema.decode(dataPoint); }
 
 private:
+    Schema _schema;
+
     void lockUnlock(uint8_t memberId, bool shouldLock, std::function<void(TuyaBLEDevice*)> callback);
 };
 
@@ -0,0 +1,44 @@
+#ifndef TUYA_BLE_CRYPTO_CONTEXT_123
+#define TUYA_BLE_CRYPTO_CONTEXT_123
+
+#include "CryptoHelper.h"
+#include "TuyaBLEConstants.h"
+
+/// The keys a device uses to encrypt and decrypt messages. Both keys are expanded
+/// once: the local key when the credentials are known, the session key when the
+/// key-exchange completes. They're kept until the credentials change or the session ends.
+class TuyaBLECryptoContext {
+private:
+    /// key = md5(localKey.prefixUpTo(6))
+    AesCbc128Key _localKey;
+
+    /// key = md5(localKey.prefixUpTo(6) + srand)
+    AesCbc128Key _sessionKey;
+
+public:
+    void setLocalKey(const Buffer& key) { _localKey.setKey(key.data()); }
+    void setSessionKey(const Buffer& key) { _sessionKey.setKey(key.data()); }
+
+    bool hasLocalKey() const { return _localKey.isSet(); }
+    bool hasSessionKey() const { return _sessionKey.isSet(); }
+
+    /// forgets the session key, the local key stays valid for the next session
+    void endSession() { _sessionKey.clear(); }
+
+    /// forgets all keys, e.g. when the credentials change
+    void clear() {
+        _localKey.clear();
+        _sessionKey.clear();
+    }
+
+    /// returns the key to use for a security flag, or nullptr if we don't have that key (yet)
+    const AesCbc128Key* keyForFlag(TuyaBLESecurityFlag flag) const {
+        switch(flag) {
+            case TuyaBLESecurityFlag::localKey: return _localKey.isSet() ? &_localKey : nullptr;
+            case TuyaBLESecurityFlag::sessionKey: return _sessionKey.isSet() ? &_sessionKey : nullptr;
+            default: return nullptr;
+        }
+    }
+};
+
+#endif//TUYA_BLE_CRYPTO_CONTEXT_123
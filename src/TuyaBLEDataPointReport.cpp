@@ -0,0 +1,78 @@
+#include "TuyaBLEDataPointReport.h"
+
+bool TuyaBLEDataPointReport::isReport(TuyaBLEFunctionCode code) {
+  switch(code) {
+    case TuyaBLEFunctionCode::receiveDp:
+    case TuyaBLEFunctionCode::receiveTimeDp:
+    case TuyaBLEFunctionCode::receiveSignDp:
+    case TuyaBLEFunctionCode::receiveSignTimeDp:
+    case TuyaBLEFunctionCode::receiveDpV4:
+    case TuyaBLEFunctionCode::receiveTimeDpV4:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+bool TuyaBLEDataPointReport::parse(const TuyaBLEReceivedMessage& message) {
+  if(!isReport(message.functionCode)) return false;
+
+  TuyaBLEFunctionCode code = message.functionCode;
+  bool isV4 = code == TuyaBLEFunctionCode::receiveDpV4 || code == TuyaBLEFunctionCode::receiveTimeDpV4;
+  bool isSigned = code == TuyaBLEFunctionCode::receiveSignDp || code == TuyaBLEFunctionCode::receiveSignTimeDp;
+  hasTimestamp = code == TuyaBLEFunctionCode::receiveTimeDp || code == TuyaBLEFunctionCode::receiveSignTimeDp || code == TuyaBLEFunctionCode::receiveTimeDpV4;
+  numberOfLengthBytes = isV4 ? 2 : 1;
+
+  ByteReader reader(message.data);
+  if(isV4) {
+    acknowledgementHeader = reader.readBuffer(6);
+    wantsAcknowledgement = reader.readUint8() == 0;
+  } else {
+    // v3 sequence numbers are 16 bits, the device's `tuya_ble_dp_data_with_flag_report()` takes a uint16_t
+    acknowledgementHeader = reader.readBuffer(isSigned ? 3 : 0);
+    wantsAcknowledgement = code != TuyaBLEFunctionCode::receiveDp;
+  }
+
+  timestampMs = hasTimestamp ? readTimestampMs(reader) : 0;
+  dataPoints = reader.readRemaining();
+  return reader.isValid();
+}
+
+void TuyaBLEDataPointReport::appendAcknowledgement(Buffer& output) const {
+  output.append(acknowledgementHeader);
+  output.append(static_cast<uint8_t>(0));
+}
+
+bool TuyaBLEDataPointReport::parseItems(const BufferView& data, size_t numberOfLengthBytes, TuyaBLEReceivedDataPointItems& items) {
+  items.reserve(data.size() / 4);
+
+  ByteReader reader(data);
+  while(reader.remaining() >= 3 + numberOfLengthBytes) {
+    TuyaBLEReceivedDataPointItem item;
+    item.dp = reader.readUint8();
+    item.type = static_cast<TuyaDataPointType>(reader.readUint8());
+    size_t dataLength = numberOfLengthBytes == 2 ? reader.readBigEndianUint16() : reader.readUint8();
+    item.data = reader.readBuffer(dataLength);
+    items.push_back(item);
+  }
+
+  return reader.isValid();
+}
+
+uint64_t TuyaBLEDataPointReport::readTimestampMs(ByteReader& reader) {
+  uint8_t timeType = reader.readUint8();
+  if(timeType != 0)
+    return static_cast<uint64_t>(reader.readBigEndianUint32()) * 1000;
+
+  BufferView digits = reader.readBuffer(13);
+  uint64_t timestampMs = 0;
+  for(size_t index = 0; index < digits.size(); index++) {
+    if(digits[index] < '0' || digits[index] > '9') {
+      reader.fail();
+      return 0;
+    }
+    timestampMs = timestampMs * 10 + (digits[index] - '0');
+  }
+  return timestampMs;
+}
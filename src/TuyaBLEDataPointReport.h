@@ -0,0 +1,106 @@
+#ifndef TUYA_BLE_DATAPOINT_REPORT_123
+#define TUYA_BLE_DATAPOINT_REPORT_123
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "Buffer.h"
+#include "BufferArena.h"
+#include "BufferView.h"
+#include "ByteReader.h"
+#include "TuyaBLEReceivedMessage.h"
+#include "TuyaDataPoint.h"
+
+/// A single datapoint item in a received datapoints message, still pointing into the message
+struct TuyaBLEReceivedDataPointItem {
+  uint8_t dp;
+  TuyaDataPointType type;
+  BufferView data;
+
+  TuyaDataPoint toDataPoint() const {
+    TuyaDataPoint dataPoint(dp, type);
+    switch(type) {
+      case TuyaDataPointType::raw:
+       dataPoint.setRaw(data);
+      break;
+
+      case TuyaDataPointType::boolean:
+        dataPoint.setBoolean(data.asBigEndianUnsignedInt() != 0);
+      break;
+
+      case TuyaDataPointType::value:
+        dataPoint.setValue(data.asBigEndianSignedInt());
+      break;
+
+      case TuyaDataPointType::string:
+        dataPoint.setString(data);
+      break;
+
+      case TuyaDataPointType::enumeration:
+        dataPoint.setEnumeration(data.asBigEndianUnsignedInt());
+      break;
+
+      case TuyaDataPointType::bitmap:
+        dataPoint.setBitmap(data);
+      break;
+    }
+    return dataPoint;
+  }
+};
+
+typedef std::vector<TuyaBLEReceivedDataPointItem, BufferArenaAllocator<TuyaBLEReceivedDataPointItem>> TuyaBLEReceivedDataPointItems;
+
+/// A datapoints report from the device: what comes before its datapoints, and how to acknowledge it.
+///
+/// receiveDp:         D...D
+/// receiveTimeDp:     t|X...X|D...D
+/// receiveSignDp:     S|S|M|D...D
+/// receiveSignTimeDp: S|S|M|t|X...X|D...D
+/// receiveDpV4:       S|S|S|S|T|M|A|D...D
+/// receiveTimeDpV4:   S|S|S|S|T|M|A|t|X...X|D...D
+///
+/// S = datapoint sequence number of the device, big endian: 16 bits in protocol v3, 32 bits in v4
+/// T = type of report, M = mode of report
+/// A = 0 if the device wants us to acknowledge a v4 report
+/// t|X...X = time, see `readTimestampMs()`
+/// D...D = datapoints, with a 1 byte length in v3 and 2 bytes in v4, see `parseItems()`
+///
+/// The device keeps timestamped, signed and v4 reports until we acknowledge them with the same function code,
+/// echoing their header (S|S|M for signed v3 reports, S|S|S|S|T|M for v4, nothing for receiveTimeDp) followed by a status of 0
+class TuyaBLEDataPointReport {
+public:
+  bool wantsAcknowledgement = false;
+  BufferView acknowledgementHeader;
+  bool hasTimestamp = false;
+  uint64_t timestampMs = 0;
+  size_t numberOfLengthBytes = 1;
+  BufferView dataPoints;
+
+  static bool isReport(TuyaBLEFunctionCode code);
+
+  /// parses the part of `message` in front of its datapoints, returns false if it's malformed or not a report
+  bool parse(const TuyaBLEReceivedMessage& message);
+
+  /// the data of the message that acknowledges this report
+  void appendAcknowledgement(Buffer& output) const;
+
+  /// parses all datapoint items of the report, returns false if they're malformed
+  bool parseItems(TuyaBLEReceivedDataPointItems& items) const { return parseItems(dataPoints, numberOfLengthBytes, items); }
+
+  /// parses all datapoint items in `data`, returns false if they're malformed. Format, repeated:
+  /// I|T|L|D...D
+  ///
+  /// I = datapoint id
+  /// T = one of TuyaDataPointType
+  /// L = length of data, `numberOfLengthBytes` big endian
+  /// D...D = data of the datapoint, `L` number of bytes
+  static bool parseItems(const BufferView& data, size_t numberOfLengthBytes, TuyaBLEReceivedDataPointItems& items);
+
+  /// reads the time of a timestamped report: a type, followed by 13 ascii digits of
+  /// milliseconds for type 0 or 4 bytes of seconds big endian otherwise
+  static uint64_t readTimestampMs(ByteReader& reader);
+};
+
+#endif//TUYA_BLE_DATAPOINT_REPORT_123
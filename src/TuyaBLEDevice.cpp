@@ -6,89 +6,37 @@
 #include <NimBLERemoteCharacteristic.h>
 
 #include "Buffer.h"
+#include "ByteReader.h"
 #include "CryptoHelper.h"
+#include "Crc16.h"
+#include "TuyaBLEDataPointReport.h"
+#include "TuyaBLEReceivedMessage.h"
 
-/// A parsed response packet
-struct TuyaBLEResponseParsedPacket {
-  uint32_t packetNumber;
-  uint32_t messageLength;
-  uint8_t protocolVersion;
-  Buffer data;
-
- static TuyaBLEResponseParsedPacket fromData(const Buffer& data) {
-  if(data.size() < 1) return TuyaBLEResponseParsedPacket();
-
-  TuyaBLEResponseParsedPacket parsedPacket;
-
-  size_t offset = 0;
-  parsedPacket.packetNumber = data.readPackedInt(offset);
-  parsedPacket.messageLength = 0;
-  parsedPacket.protocolVersion = 0;
-  if(parsedPacket.packetNumber == 0) {
-    parsedPacket.messageLength = data.readPackedInt(offset);
-    parsedPacket.protocolVersion = data.readUint8(offset) >> 4;
-  }
-
-  parsedPacket.data = data.suffixFrom(offset);
-  return parsedPacket;
- }
-};
-
-/// A parsed received message
-class TuyaBLEReceivedMessage {
-public:
-  TuyaBLEFunctionCode functionCode;
-  uint32_t sequenceNumber = 0;
-  uint32_t responseToSequenceNumber = 0;
-  Buffer data;
-
-  String debugDescription() const {
-    String output;
-    output += "code = " + String(static_cast<uint16_t>(functionCode), HEX);
-    output += ", seq = " + String(sequenceNumber);
-    output += ", rseq = " + String(responseToSequenceNumber);
-    output += ", data = " + data.debugDescription();
-    return output;
-  }
-};
+#include <algorithm>
+#include <sys/time.h>
+#include <time.h>
 
 const String TuyaBLEDevice::emptyString = String();
 
 void TuyaBLEDevice::setCredentials(const TuyaDeviceCredentials& credentials) {
   this->_credentials = credentials;
-  _localKeyMD5 = Buffer();
-}
-
-void TuyaBLEDevice::clearExpectedResponse() {
-  _expectedResponsePacketNumber = 0;
-	_expectedResponseDataLength = 0;
-	_receivedData = Buffer();
+  _crypto.clear();
 }
 
 void TuyaBLEDevice::onNotify(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify) {
-  auto packet = TuyaBLEResponseParsedPacket::fromData(Buffer(data, length));
-  if(packet.packetNumber != _expectedResponsePacketNumber) return;
-
-  //Serial.printf("Received packet %ld\n", packet->packetNumber);
-		
-	if(packet.packetNumber == 0) {
-		_receivedData = Buffer();
-		_expectedResponseDataLength = packet.messageLength;
-	}
-
-  _receivedData.append(packet.data);
-  if(_receivedData.size() < _expectedResponseDataLength) {
-    _expectedResponsePacketNumber += 1;
-  } else if(_receivedData.size() == _expectedResponseDataLength) {
-    auto completeData = _receivedData;
-    clearExpectedResponse();
-    handleReceivedMessageData(completeData);
-  } else {
-    // dunno what to do here
+  xSemaphoreTake(_receiveMutex, portMAX_DELAY);
+  auto result = _reassembler.addPacket(BufferView(data, length), millis(), _statistics);
+  xSemaphoreGive(_receiveMutex);
+
+  // a completed message is no longer in progress, so expiring it from the sender task leaves it alone
+  if(result == TuyaBLEMessageReassembler::Result::complete) {
+    // the reassembled bytes are decrypted in place, the reassembler keeps
+    // their capacity around for the next message
+    handleReceivedMessageData(_reassembler.message());
   }
 }
 
-void TuyaBLEDevice::handleReceivedMessageData(const Buffer& data) {
+void TuyaBLEDevice::handleReceivedMessageData(Buffer& data) {
 		// which gets encrypted as data:
 		//
 		// .|0123456789ABCDEF|0123456789ABCDEF
@@ -98,18 +46,37 @@ void TuyaBLEDevice::handleReceivedMessageData(const Buffer& data) {
 		// I...I = random IV vector (16 bytes)
 		// E...E = aes(key, iv, data)
 
-    if(data.size() < 16 + 16 + 1) return;
-		
-		size_t offset = 0;
-    TuyaBLESecurityFlag securityFlag = static_cast<TuyaBLESecurityFlag>(data.readUint8(offset));
-    Buffer iv = data.readBuffer(offset, 16);
-    Buffer encryptedMessageData = data.suffixFrom(offset);
-    Buffer key = keyToUseForFlag(securityFlag);
-    Buffer decryptedMessageData = encryptedMessageData.aesCbc128Decrypt(key, iv);
-		parseAndHandleReceivedMessage(decryptedMessageData);
+    if(data.size() < 16 + 16 + 1 || (data.size() - 1) % 16 != 0) {
+      rejectReceivedFrame(TuyaBLEFrameRejectionReason::malformed);
+      return;
+    }
+
+    // everything decoded from this message is released when we're done handling it
+    BufferArenaScope scope(_receiveArena);
+
+    ByteReader reader(data);
+    TuyaBLESecurityFlag securityFlag = static_cast<TuyaBLESecurityFlag>(reader.readUint8());
+    BufferView iv = reader.readBuffer(16);
+    size_t encryptedMessageDataOffset = reader.offset();
+    if(!reader.isValid()) {
+      rejectReceivedFrame(TuyaBLEFrameRejectionReason::malformed);
+      return;
+    }
+
+    const AesCbc128Key* key = keyToUseForFlag(securityFlag);
+    if(key == nullptr) {
+      rejectReceivedFrame(TuyaBLEFrameRejectionReason::noKey);
+      return;
+    }
+
+    // we decrypt in place, the reassembled bytes aren't needed after this
+    uint8_t* messageData = data.data() + encryptedMessageDataOffset;
+    size_t messageDataLength = data.size() - encryptedMessageDataOffset;
+    key->decryptInPlace(iv.data(), messageData, messageDataLength);
+		parseAndHandleReceivedMessage(BufferView(messageData, messageDataLength));
 }
 
-void TuyaBLEDevice::parseAndHandleReceivedMessage(const Buffer& data) {
+void TuyaBLEDevice::parseAndHandleReceivedMessage(const BufferView& data) {
   // format:
   // 0123|45678|9A|BC|D....|..
   // SSSS|RRRR||CC|LL|D...D|XX
@@ -124,56 +91,146 @@ void TuyaBLEDevice::parseAndHandleReceivedMessage(const Buffer& data) {
 
   TuyaBLEReceivedMessage receivedMessage;
 
-  size_t offset = 0;
-  receivedMessage.sequenceNumber = data.readBigEndianUint32(offset);
-  receivedMessage.responseToSequenceNumber = data.readBigEndianUint32(offset);
-  receivedMessage.functionCode = static_cast<TuyaBLEFunctionCode>(data.readBigEndianUint16(offset));
-  uint16_t dataLength = data.readBigEndianUint16(offset);
-  receivedMessage.data = data.readBuffer(offset, static_cast<size_t>(dataLength));
-  uint16_t crc = data.readBigEndianUint16(offset);
-  
+  ByteReader reader(data);
+  receivedMessage.sequenceNumber = reader.readBigEndianUint32();
+  receivedMessage.responseToSequenceNumber = reader.readBigEndianUint32();
+  receivedMessage.functionCode = static_cast<TuyaBLEFunctionCode>(reader.readBigEndianUint16());
+  uint16_t dataLength = reader.readBigEndianUint16();
+  receivedMessage.data = reader.readBuffer(static_cast<size_t>(dataLength));
+  size_t checkedLength = reader.offset();
+  uint16_t crc = reader.readBigEndianUint16();
+  if(!reader.isValid()) {
+    rejectReceivedFrame(TuyaBLEFrameRejectionReason::invalidLength);
+    return;
+  }
+
+  // a wrong key or a corrupted packet decrypts to garbage, which we don't want to dispatch
+  if(crc != Crc16::compute(data.data(), checkedLength)) {
+    rejectReceivedFrame(TuyaBLEFrameRejectionReason::invalidCrc);
+    return;
+  }
+
+  _statistics.receivedMessages += 1;
   handleReceivedFunction(receivedMessage);
 }
 
+void TuyaBLEDevice::rejectReceivedFrame(TuyaBLEFrameRejectionReason reason) {
+  _statistics.recordRejectedFrame(reason);
+  if(_isDebugLogEnabled)
+    debugLog("[Error] rejected received frame: " + String(TuyaBLEFrameRejectionReasonName(reason)));
+
+  if(_onRejectedFrameCallback)
+    _onRejectedFrameCallback(this, reason);
+}
+
 void TuyaBLEDevice::handleReceivedFunction(const TuyaBLEReceivedMessage& message) {
   if(_isDebugLogEnabled)
     debugLog("[Received] message: " + message.debugDescription());
 
-  if(message.functionCode == TuyaBLEFunctionCode::senderDeviceInfo) {
-    handleReceivedResponseSenderDeviceInfo(message);
-  } else if(message.functionCode == TuyaBLEFunctionCode::senderPair) {
-    handleReceivedResponseSenderPair(message);
-  } else if(message.functionCode == TuyaBLEFunctionCode::senderDps) {
-    handleReceivedResponseSenderDps(message);
-  } else if(message.functionCode == TuyaBLEFunctionCode::receiveTime1Req) {
+  // responses to our requests are matched by the sequence number they respond to, whatever their function code
+  if(message.responseToSequenceNumber != 0 && _requests.complete(message, message.responseToSequenceNumber)) {
+    return;
+  }
+
+  if(message.functionCode == TuyaBLEFunctionCode::receiveTime1Req) {
     handleReceivedRequestReceiveTime1Req(message);
-  } else if(message.functionCode == TuyaBLEFunctionCode::receiveDp) {
-    handleReceivedReceiveDP(message);
+  } else if(message.functionCode == TuyaBLEFunctionCode::receiveTime2Req) {
+    handleReceivedRequestReceiveTime2Req(message);
+  } else if(TuyaBLEDataPointReport::isReport(message.functionCode)) {
+    handleReceivedDataPointReport(message);
+  } else if(_isDebugLogEnabled && message.responseToSequenceNumber != 0) {
+    debugLog("[Received] response to unknown or expired request seq = " + String(message.responseToSequenceNumber));
   }
 }
 
-void TuyaBLEDevice::handleReceivedResponseSenderDps(const TuyaBLEReceivedMessage& message) {
-  if(auto callback = _waitingOnResponseSendDpsCallbacks[message.responseToSequenceNumber]) {
-    _waitingOnResponseSendDpsCallbacks.erase(message.responseToSequenceNumber);
-    callback(this);
-  }
+// MARK: - Time
+uint64_t TuyaBLEDevice::systemTimeMs() {
+  struct timeval now;
+  if(gettimeofday(&now, nullptr) != 0) return 0;
+
+  // until the clock has been set, e.g. with sntp, it starts at the epoch
+  if(now.tv_sec < minimumValidUnixTime) return 0;
+  return static_cast<uint64_t>(now.tv_sec) * 1000 + now.tv_usec / 1000;
+}
+
+bool TuyaBLEDevice::currentTimeMs(uint64_t& timeMs) {
+  timeMs = _timeSource ? _timeSource() : 0;
+  if(timeMs != 0) return true;
+
+  if(_isDebugLogEnabled)
+    debugLog("[Error] time requested, but the time isn't known");
+  return false;
+}
+
+int16_t TuyaBLEDevice::timeZoneForResponse() const {
+  // tuya sends time zones in hundredths of hours
+  return static_cast<int16_t>(_timeZoneOffsetMinutes * 100 / 60);
 }
 
 void TuyaBLEDevice::handleReceivedRequestReceiveTime1Req(const TuyaBLEReceivedMessage& message) {
-  // we discard those, because our time might not be great
+  // response format:
+  // X...X|Z|Z
+  //
+  // X...X = milliseconds since the unix epoch, as 13 ascii digits
+  // Z = time zone in hundredths of hours, big endian signed
+  _statistics.timeRequests += 1;
+  uint64_t timeMs;
+  if(!currentTimeMs(timeMs)) return;
+
+  char digits[14];
+  snprintf(digits, sizeof(digits), "%013llu", static_cast<unsigned long long>(timeMs));
+
+  Buffer data;
+  data.append(reinterpret_cast<const uint8_t*>(digits), 13);
+  data.appendBigEndian(timeZoneForResponse());
+  if(sendMessage(message.functionCode, data, message.sequenceNumber) != 0)
+    _statistics.answeredTimeRequests += 1;
+}
+
+void TuyaBLEDevice::handleReceivedRequestReceiveTime2Req(const TuyaBLEReceivedMessage& message) {
+  // response format, in local time:
+  // Y|M|D|h|m|s|W|Z|Z
+  //
+  // Y = year - 2000, M = month 1-12, D = day of month 1-31
+  // h, m, s = hours, minutes and seconds
+  // W = day of week, 0 is monday
+  // Z = time zone in hundredths of hours, big endian signed
+  _statistics.timeRequests += 1;
+  uint64_t timeMs;
+  if(!currentTimeMs(timeMs)) return;
+
+  time_t localTime = static_cast<time_t>(timeMs / 1000) + static_cast<time_t>(_timeZoneOffsetMinutes) * 60;
+  struct tm components;
+  gmtime_r(&localTime, &components);
+
+  Buffer data;
+  data.append(static_cast<uint8_t>(components.tm_year % 100));
+  data.append(static_cast<uint8_t>(components.tm_mon + 1));
+  data.append(static_cast<uint8_t>(components.tm_mday));
+  data.append(static_cast<uint8_t>(components.tm_hour));
+  data.append(static_cast<uint8_t>(components.tm_min));
+  data.append(static_cast<uint8_t>(components.tm_sec));
+  data.append(static_cast<uint8_t>((components.tm_wday + 6) % 7));
+  data.appendBigEndian(timeZoneForResponse());
+  if(sendMessage(message.functionCode, data, message.sequenceNumber) != 0)
+    _statistics.answeredTimeRequests += 1;
 }
 
 void TuyaBLEDevice::handleReceivedResponseSenderDeviceInfo(const TuyaBLEReceivedMessage& message) {
-  const Buffer& data = message.data;
+  const BufferView& data = message.data;
   if(data.size() < 46) return;
 
   _infoDeviceVersion = String(data[0]) + "." + String(data[1]);
   _infoProtocolVersion = String(data[2]) + "." + String(data[3]);
   _infoHardwareVersion = String(data[12]) + "." + String(data[13]);
 
-  Buffer srand = data.subRangeWithStartAndLength(6, 6);
-  Buffer authKey = data.subRangeWithStartAndLength(14, 32);
-  _sessionKey = (_localKeyFirstSixBytes + srand).md5();
+  BufferView srand = data.subRangeWithStartAndLength(6, 6);
+  BufferView authKey = data.subRangeWithStartAndLength(14, 32);
+
+  Buffer sessionKeySeed = _localKeyFirstSixBytes;
+  sessionKeySeed.append(srand);
+  Buffer sessionKey = sessionKeySeed.md5();
+  _crypto.setSessionKey(sessionKey);
 
     if(_isDebugLogEnabled) {
     debugLog("[Received] senderDeviceInfo response: key handshake complete");
@@ -181,7 +238,7 @@ void TuyaBLEDevice::handleReceivedResponseSenderDeviceInfo(const TuyaBLEReceived
     debugLog("[Info] protocol version: " + _infoProtocolVersion);
     debugLog("[Info] hardware version: " + _infoHardwareVersion);
     debugLog("[Info] session srand nonce: " + srand.debugDescription());
-    debugLog("[Info] session key: " + _sessionKey.debugDescription());
+    debugLog("[Info] session key: " + sessionKey.debugDescription());
   }
 
   sendPairingRequest();
@@ -201,119 +258,316 @@ void TuyaBLEDevice::handleReceivedResponseSenderPair(const TuyaBLEReceivedMessag
     _onReadyCallback(this);
 }
 
-void TuyaBLEDevice::handleReceivedReceiveDP(const TuyaBLEReceivedMessage& message) {
-  size_t offset = 0;
-  const Buffer& data = message.data;
-
-  std::vector<TuyaDataPoint> receivedDataPoints;
-
-  while(data.size() - offset >= 4) {
-
-    uint8_t dp = data.readUint8(offset);
-    TuyaDataPointType type = static_cast<TuyaDataPointType>(data.readUint8(offset));
-
-    TuyaDataPoint dataPoint(dp, type);
-    uint8_t dataLength = data.readUint8(offset);
-    Buffer itemData = data.subRangeWithStartAndLength(offset, static_cast<size_t>(dataLength));
-
-    switch(type) {
-      case TuyaDataPointType::raw:
-       dataPoint.setRaw(itemData); 
-      break;
-
-      case TuyaDataPointType::boolean:
-        dataPoint.setBoolean(itemData.asBigEndianUnsignedInt() != 0);
-      break;
-
-      case TuyaDataPointType::value:
-        dataPoint.setValue(itemData.asBigEndianSignedInt());
-      break;
+// MARK: - Received datapoints
+void TuyaBLEDevice::handleReceivedDataPointReport(const TuyaBLEReceivedMessage& message) {
+  TuyaBLEDataPointReport report;
+  if(!report.parse(message)) {
+    if(_isDebugLogEnabled)
+      debugLog("[Error] malformed datapoints report");
+    return;
+  }
 
-      case TuyaDataPointType::string:
-        dataPoint.setString(itemData.asString());
-      break;
+  bool isHandled = report.hasTimestamp
+    ? handleReceivedTimestampedDataPoints(report.dataPoints, report.numberOfLengthBytes, report.timestampMs)
+    : handleReceivedDataPoints(report.dataPoints, report.numberOfLengthBytes);
 
-      case TuyaDataPointType::enumeration:
-        dataPoint.setEnumeration(itemData.asBigEndianUnsignedInt());
-      break;
+  // the device keeps sending the report until it's acknowledged
+  if(isHandled && report.wantsAcknowledgement) {
+    Buffer data;
+    report.appendAcknowledgement(data);
+    if(sendMessage(message.functionCode, data, message.sequenceNumber) != 0)
+      _statistics.acknowledgedReports += 1;
+  }
+}
 
-      case TuyaDataPointType::bitmap:
-        dataPoint.setBitmap(itemData);
-      break;
-    }
+bool TuyaBLEDevice::handleReceivedDataPoints(const BufferView& data, size_t numberOfLengthBytes) {
+  // we parse all items first, so a malformed message is rejected as a whole
+  // instead of reporting the items up to the point where it went wrong
+  TuyaBLEReceivedDataPointItems items{BufferArenaAllocator<TuyaBLEReceivedDataPointItem>(&_receiveArena)};
+  if(!TuyaBLEDataPointReport::parseItems(data, numberOfLengthBytes, items)) {
+    if(_isDebugLogEnabled)
+      debugLog("[Error] malformed datapoints message");
+    return false;
+  }
 
-    offset += dataLength;
+  _changedDataPoints.clear();
+  for(auto&& item : items) {
+    TuyaDataPoint dataPoint = item.toDataPoint();
 
     if(_isDebugLogEnabled) {
       debugLog("[Received] Datapoint: " + dataPoint.debugDescription());
     }
 
-    receivedDataPoints.push_back(dataPoint);
-    _reportedDataPoints.insert(std::pair<uint16_t, TuyaDataPoint>(dataPoint.dp(), dataPoint));
+    TuyaDPDecodeResult decodeResult = decodeReportedDataPoint(dataPoint);
+    bool hasChanged = decodeResult == TuyaDPDecodeResult::notInSchema ? _reportedDataPoints.set(dataPoint) : decodeResult == TuyaDPDecodeResult::changed;
+    if(hasChanged) {
+      _changedDataPoints.insert(dataPoint.dp());
+      _statistics.changedDataPoints += 1;
+    } else {
+      _statistics.unchangedDataPoints += 1;
+    }
 
     if(_onReceivedDataPointCallback)
       _onReceivedDataPointCallback(this, dataPoint);
+
+    if(hasChanged && _subscribedDataPoints.contains(dataPoint.dp()))
+      callDataPointSubscriptions(dataPoint);
   }
 
+  if(_onChangedDataPointsCallback && !_changedDataPoints.isEmpty())
+    _onChangedDataPointsCallback(this, _changedDataPoints);
+
   if(_onUpdatedReportedDataPointsCallback)
     _onUpdatedReportedDataPointsCallback(this);
+  return true;
+}
+
+// MARK: - Datapoint subscriptions
+uint32_t TuyaBLEDevice::subscribeToDataPoint(uint8_t dp, std::function<void(TuyaBLEDevice*, const TuyaDataPoint&)> callback) {
+  if(!callback) return 0;
+
+  _lastSubscriptionToken += 1;
+  _dataPointSubscriptions.push_back(DataPointSubscription{_lastSubscriptionToken, dp, callback});
+  _subscribedDataPoints.insert(dp);
+  return _lastSubscriptionToken;
+}
+
+void TuyaBLEDevice::unsubscribeFromDataPoint(uint32_t token) {
+  for(auto& subscription : _dataPointSubscriptions) {
+    if(subscription.token == token)
+      subscription.callback = nullptr;
+  }
+
+  if(!_isCallingSubscriptions)
+    removeUnsubscribedDataPointSubscriptions();
+}
+
+void TuyaBLEDevice::removeUnsubscribedDataPointSubscriptions() {
+  _dataPointSubscriptions.erase(std::remove_if(_dataPointSubscriptions.begin(), _dataPointSubscriptions.end(), [](const DataPointSubscription& subscription) {
+    return !subscription.callback;
+  }), _dataPointSubscriptions.end());
+
+  _subscribedDataPoints.clear();
+  for(auto&& subscription : _dataPointSubscriptions)
+    _subscribedDataPoints.insert(subscription.dp);
+}
+
+void TuyaBLEDevice::callDataPointSubscriptions(const TuyaDataPoint& dataPoint) {
+  // subscriptions added by a callback are only called for the next change, since we stop at the current size
+  bool wasCallingSubscriptions = _isCallingSubscriptions;
+  _isCallingSubscriptions = true;
+  size_t numberOfSubscriptions = _dataPointSubscriptions.size();
+  for(size_t index = 0; index < numberOfSubscriptions; index++) {
+    if(_dataPointSubscriptions[index].dp != dataPoint.dp() || !_dataPointSubscriptions[index].callback) continue;
+
+    // the vector might grow while the callback runs, so it's called from a copy
+    auto callback = _dataPointSubscriptions[index].callback;
+    callback(this, dataPoint);
+  }
+  _isCallingSubscriptions = wasCallingSubscriptions;
+
+  if(!_isCallingSubscriptions)
+    removeUnsubscribedDataPointSubscriptions();
+}
+
+bool TuyaBLEDevice::handleReceivedTimestampedDataPoints(const BufferView& data, size_t numberOfLengthBytes, uint64_t timestampMs) {
+  TuyaBLEReceivedDataPointItems items{BufferArenaAllocator<TuyaBLEReceivedDataPointItem>(&_receiveArena)};
+  if(!TuyaBLEDataPointReport::parseItems(data, numberOfLengthBytes, items)) {
+    if(_isDebugLogEnabled)
+      debugLog("[Error] malformed timestamped datapoints message");
+    return false;
+  }
+
+  // timestamped datapoints are history the device stored, such as a log of
+  // unlocks, so they don't change the reported datapoints
+  std::vector<TuyaDataPoint> dataPoints;
+  dataPoints.reserve(items.size());
+  for(auto&& item : items)
+    dataPoints.push_back(item.toDataPoint());
+
+  if(_isDebugLogEnabled) {
+    for(auto&& dataPoint : dataPoints)
+      debugLog("[Received] Datapoint at " + String(static_cast<uint32_t>(timestampMs / 1000)) + ": " + dataPoint.debugDescription());
+  }
+
+  _statistics.timestampedDataPoints += dataPoints.size();
+  if(_onReceivedTimestampedDataPointsCallback)
+    _onReceivedTimestampedDataPointsCallback(this, timestampMs, dataPoints);
+  return true;
 }
 
 void TuyaBLEDevice::sendDataPoints(const std::vector<TuyaDataPoint>& dps, std::function<void(TuyaBLEDevice*)> callback) {
-  Buffer data;
-  for(auto&& dataPoint : dps) {
-    data.append(dataPoint.dp());
-    data.append(static_cast<uint8_t>(dataPoint.type()));
-
-    size_t numberOfLengthBytes = (_deviceInfo.protocolVersion() >= 4 ? 2 : 1);
-    switch(dataPoint.type()) {
-      case TuyaDataPointType::raw:
-        data.appendBigEndianWithNumberOfBytes(dataPoint.raw().size(), numberOfLengthBytes);
-        data.append(dataPoint.raw());
-      break;
-
-      case TuyaDataPointType::boolean:
-        data.appendBigEndianWithNumberOfBytes(1, numberOfLengthBytes);
-        data.append(static_cast<uint8_t>(dataPoint.boolean() ? 1 : 0));
-      break;
-
-      case TuyaDataPointType::value:
-        data.appendBigEndianWithNumberOfBytes(4, numberOfLengthBytes);
-        data.append(dataPoint.value());
-      break;
-
-      case TuyaDataPointType::string:
-        data.appendBigEndianWithNumberOfBytes(dataPoint.string().length(), numberOfLengthBytes);
-        data.append(dataPoint.string());
-      break;
-
-      case TuyaDataPointType::enumeration:
-        data.appendBigEndianWithNumberOfBytes(4, numberOfLengthBytes);
-        data.append(dataPoint.value());
-      break;
-
-      case TuyaDataPointType::bitmap:
-        data.appendBigEndianWithNumberOfBytes(dataPoint.bitmap().size(), numberOfLengthBytes);
-        data.append(dataPoint.bitmap());
-      break;
+  sendDataPoints(dps.data(), dps.size(), callback);
+}
+
+void TuyaBLEDevice::sendDataPoints(const TuyaDataPoint* dps, size_t numberOfDataPoints, std::function<void(TuyaBLEDevice*)> callback) {
+  if(!callback) {
+    sendDataPointsWithStatus(dps, numberOfDataPoints, TuyaBLEStatusCallback());
+    return;
+  }
+
+  // the callback is only called when the device confirmed the datapoints
+  sendDataPointsWithStatus(dps, numberOfDataPoints, [callback](TuyaBLEDevice* device, TuyaBLERequestStatus status) {
+    if(status == TuyaBLERequestStatus::success)
+      callback(device);
+  });
+}
+
+void TuyaBLEDevice::sendDataPointsWithStatus(const std::vector<TuyaDataPoint>& dps, TuyaBLEStatusCallback callback) {
+  sendDataPointsWithStatus(dps.data(), dps.size(), callback);
+}
+
+void TuyaBLEDevice::sendDataPointsWithStatus(const TuyaDataPoint* dps, size_t numberOfDataPoints, TuyaBLEStatusCallback callback) {
+  beginSending();
+  // pending writes are sent from the sender task, without it there's nobody to send them
+  if(_dataPointCoalescingWindowMs > 0 && _transmitQueue.isRunning() && _transmitQueue.hasSenderTask()) {
+    coalesceDataPoints(dps, numberOfDataPoints, callback);
+  } else {
+    std::vector<TuyaBLEStatusCallback> callbacks;
+    if(callback)
+      callbacks.push_back(std::move(callback));
+    transmitDataPoints(dps, numberOfDataPoints, callbacks);
+  }
+  endSending();
+}
+
+// MARK: - Coalescing datapoint writes
+void TuyaBLEDevice::setDataPointCoalescingWindow(uint32_t windowMs) {
+  _dataPointCoalescingWindowMs = windowMs;
+  _transmitQueue.setTickInterval(timerServiceIntervalMs());
+  if(windowMs == 0)
+    flushDataPoints();
+}
+
+uint32_t TuyaBLEDevice::timerServiceIntervalMs() const {
+  // pending writes should go out close to the end of their window
+  if(_dataPointCoalescingWindowMs > 0 && _dataPointCoalescingWindowMs < requestServiceIntervalMs)
+    return _dataPointCoalescingWindowMs;
+  return requestServiceIntervalMs;
+}
+
+void TuyaBLEDevice::coalesceDataPoints(const TuyaDataPoint* dps, size_t numberOfDataPoints, TuyaBLEStatusCallback callback) {
+  // the window starts with the first pending write, so no write waits longer than the window
+  if(_coalescedDataPoints.empty())
+    _coalescingStartTime = millis();
+
+  for(size_t index = 0; index < numberOfDataPoints; index++) {
+    const TuyaDataPoint& dataPoint = dps[index];
+    auto it = std::find_if(_coalescedDataPoints.begin(), _coalescedDataPoints.end(), [&dataPoint](const TuyaDataPoint& pending) {
+      return pending.dp() == dataPoint.dp();
+    });
+
+    // a later write to the same datapoint replaces the pending one
+    if(it != _coalescedDataPoints.end()) {
+      *it = dataPoint;
+    } else {
+      _coalescedDataPoints.push_back(dataPoint);
     }
   }
 
-  _waitingOnResponseSendDpsCallbacks[_messageSequenceNumber + 1] = callback;
-  sendMessage(TuyaBLEFunctionCode::senderDps, data, 0, true);
+  if(callback)
+    _coalescedCallbacks.push_back(callback);
+  _numberOfCoalescedWrites += 1;
+
+  if(_coalescedDataPoints.size() >= maximumNumberOfCoalescedDataPoints)
+    flushDataPoints();
+}
+
+void TuyaBLEDevice::flushDataPoints() {
+  beginSending();
+  if(!_coalescedDataPoints.empty()) {
+    // every write but the first got merged into a message that was going out anyway
+    _statistics.coalescedDataPointWrites += _numberOfCoalescedWrites - 1;
+
+    std::vector<TuyaDataPoint> dps;
+    std::vector<TuyaBLEStatusCallback> callbacks;
+    dps.swap(_coalescedDataPoints);
+    callbacks.swap(_coalescedCallbacks);
+    _numberOfCoalescedWrites = 0;
+
+    transmitDataPoints(dps.data(), dps.size(), callbacks);
+  }
+  endSending();
+}
+
+void TuyaBLEDevice::failCoalescedDataPoints(TuyaBLERequestStatus status) {
+  beginSending();
+  if(!_coalescedCallbacks.empty()) {
+    std::vector<TuyaBLEStatusCallback> callbacks;
+    callbacks.swap(_coalescedCallbacks);
+    runAfterSending([this, callbacks, status]() {
+      for(auto&& callback : callbacks)
+        callback(this, status);
+    });
+  }
+  _coalescedDataPoints.clear();
+  _numberOfCoalescedWrites = 0;
+  endSending();
+}
+
+void TuyaBLEDevice::serviceTimers() {
+  serviceRequests();
+
+  // a partial message whose next packet never comes is given up on now, not when the next message starts.
+  // The time is read after taking the lock, so it's never older than the last packet
+  xSemaphoreTake(_receiveMutex, portMAX_DELAY);
+  _reassembler.expireStaleMessage(millis(), _statistics);
+  xSemaphoreGive(_receiveMutex);
+
+  beginSending();
+  if(!_coalescedDataPoints.empty() && millis() - _coalescingStartTime >= _dataPointCoalescingWindowMs)
+    flushDataPoints();
+  endSending();
+}
+
+// MARK: - Encoding datapoints
+void TuyaBLEDevice::transmitDataPoints(const TuyaDataPoint* dps, size_t numberOfDataPoints, std::vector<TuyaBLEStatusCallback>& callbacks) {
+  // protocol v4 has its own function code, a version byte in front and 2 byte lengths
+  bool isV4 = usesDataPointsV4();
+  TuyaBLEFunctionCode code = isV4 ? TuyaBLEFunctionCode::senderDpsV4 : TuyaBLEFunctionCode::senderDps;
+  size_t numberOfLengthBytes = isV4 ? 2 : 1;
+
+  BufferArenaScope scope(_sendArena);
+  Buffer data(_sendArena);
+  if(isV4)
+    data.append(static_cast<uint8_t>(0));
+
+  for(size_t index = 0; index < numberOfDataPoints; index++)
+    dps[index].encode(data, numberOfLengthBytes);
+
+  // the callbacks are moved into the request table with the request, its handler only captures us
+  TuyaBLERequestTable::Request request;
+  request.code = code;
+  request.statusCallbacks.swap(callbacks);
+  request.handler = [this](TuyaBLERequestStatus status, const TuyaBLEReceivedMessage*, const TuyaBLERequestTable::Request& completedRequest) {
+    if(_isDebugLogEnabled && status != TuyaBLERequestStatus::success)
+      debugLog("[Error] sending datapoints: " + String(TuyaBLERequestStatusName(status)));
+
+    for(auto&& callback : completedRequest.statusCallbacks)
+      callback(this, status);
+  };
+  sendNewRequest(request, data);
 }
 
 void TuyaBLEDevice::sendDataPoint(const TuyaDataPoint& dp, std::function<void(TuyaBLEDevice*)> callback) {
-  sendDataPoints(std::vector<TuyaDataPoint>{dp}, callback);
+  sendDataPoints(&dp, 1, callback);
+}
+
+void TuyaBLEDevice::sendDataPointWithStatus(const TuyaDataPoint& dp, TuyaBLEStatusCallback callback) {
+  sendDataPointsWithStatus(&dp, 1, callback);
 }
 
 void TuyaBLEDevice::sendPairingRequest() {
+  // runs on the BLE host task, concurrently with datapoint writes, so it doesn't use the send arena
   Buffer data;
   data.append(uuid());
   data.append(_localKeyFirstSixBytes);
   data.append(_credentials.deviceId());
   data.append(Buffer(max(size_t(0), 44 - data.size())));
-  sendMessage(TuyaBLEFunctionCode::senderPair, data, 0, true);
+  sendMessage(TuyaBLEFunctionCode::senderPair, data, 0, [this](TuyaBLERequestStatus status, const TuyaBLEReceivedMessage* response, const TuyaBLERequestTable::Request&) {
+    if(status == TuyaBLERequestStatus::success)
+      handleReceivedResponseSenderPair(*response);
+  });
 }
 
 bool TuyaBLEDevice::connect() {
@@ -323,6 +577,12 @@ bool TuyaBLEDevice::connect() {
   }
 
   _isReady = false;
+  _maximumPacketLength = minimumPacketLength;
+
+  // the preferred MTU is shared by all connections, so we only ever raise it
+  if(_preferredMtu > NimBLEDevice::getMTU())
+    NimBLEDevice::setMTU(_preferredMtu);
+
   _client = NimBLEDevice::createClient();
 
   if(!_client->connect(_deviceInfo.address(), false)) {
@@ -347,6 +607,18 @@ bool TuyaBLEDevice::connect() {
     disconnect();
     return false;
   }
+
+  // NimBLE starts the MTU exchange once the connection is up, but doesn't wait for it in `connect()`.
+  // ATT requests are handled one at a time, so the exchange has completed by the time service discovery has.
+  updateMaximumPacketLength();
+
+  _transmitQueue.setTickFunction([this]() { serviceTimers(); }, timerServiceIntervalMs());
+  _transmitQueue.start([this](const uint8_t* data, size_t length) {
+    return _writeCharacteristic->writeValue(data, length, false);
+  }, [this](uint32_t sequenceNumber, bool success) {
+    handleSentMessage(sequenceNumber, success);
+  });
+
   if(_readCharacteristic->canNotify()) {
     notify_callback callback = std::bind(&TuyaBLEDevice::onNotify, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
     _readCharacteristic->subscribe(true, callback);
@@ -372,6 +644,10 @@ bool TuyaBLEDevice::disconnect() {
 void TuyaBLEDevice::onDisconnect() {
   auto client = _client;
 
+  // queued messages fail, and no packet is being written once this returns
+  _transmitQueue.stop();
+  failCoalescedDataPoints(TuyaBLERequestStatus::disconnected);
+
   if(_readCharacteristic)
     _readCharacteristic->unsubscribe(false);
     
@@ -380,7 +656,19 @@ void TuyaBLEDevice::onDisconnect() {
   _service = nullptr;
   _readCharacteristic = nullptr;
   _writeCharacteristic = nullptr;
-  _waitingOnResponseSendDpsCallbacks.clear();
+  _maximumPacketLength = minimumPacketLength;
+
+  // the BLE host task may still be adding a packet
+  xSemaphoreTake(_receiveMutex, portMAX_DELAY);
+  _reassembler.reset();
+  xSemaphoreGive(_receiveMutex);
+
+  _requests.failAll(TuyaBLERequestStatus::disconnected);
+
+  // `sendRequest()` encrypts with the session key while holding the send lock
+  beginSending();
+  _crypto.endSession();
+  endSending();
 
   client->disconnect();
 
@@ -392,118 +680,202 @@ void TuyaBLEDevice::onDisconnect() {
 }
 
 void TuyaBLEDevice::requestDataPointsUpdate() {
-  sendMessage(TuyaBLEFunctionCode::senderDeviceStatus, Buffer(), 0, true);
+  sendMessage(TuyaBLEFunctionCode::senderDeviceStatus, Buffer());
 }
 
-Buffer TuyaBLEDevice::ensureLocalKeyMD5() {
-  if(_localKeyMD5.size() == 0) {
+void TuyaBLEDevice::ensureLocalKey() {
+  if(!_crypto.hasLocalKey()) {
     _localKeyFirstSixBytes = Buffer(_credentials.localKey().substring(0, 6).c_str(), 6);
-    _localKeyMD5 = _localKeyFirstSixBytes.md5();
-  } 
+    _crypto.setLocalKey(_localKeyFirstSixBytes.md5());
+  }
+}
 
-  return _localKeyMD5;
+void TuyaBLEDevice::updateMaximumPacketLength() {
+  // only valid after service discovery, see `connect()`. If the device didn't agree to a larger MTU this is still 23
+  uint16_t mtu = std::min(_client->getMTU(), _preferredMtu);
+  _maximumPacketLength = mtu > minimumPacketLength + attHeaderLength ? mtu - attHeaderLength : minimumPacketLength;
+
+  if(_isDebugLogEnabled)
+    debugLog("[Device] mtu: " + String(mtu) + ", maximum packet length: " + String(_maximumPacketLength));
 }
 
-Buffer TuyaBLEDevice::keyToUseForFlag(TuyaBLESecurityFlag flag) {
-  switch(flag) {
-      case TuyaBLESecurityFlag::localKey: return ensureLocalKeyMD5();
-      case TuyaBLESecurityFlag::sessionKey: return _sessionKey;
-      default: return Buffer();
+const AesCbc128Key* TuyaBLEDevice::keyToUseForFlag(TuyaBLESecurityFlag flag) {
+  if(flag == TuyaBLESecurityFlag::localKey) {
+    ensureLocalKey();
   }
+
+  return _crypto.keyForFlag(flag);
 }
 
-Buffer TuyaBLEDevice::createMessage(TuyaBLEFunctionCode code, const Buffer& data, uint32_t sequenceNumber, uint32_t responseTo) {
-    Buffer messageData;
-    messageData.appendBigEndian(sequenceNumber);
-    messageData.appendBigEndian(responseTo);
-    messageData.appendBigEndian(static_cast<uint16_t>(code));
-    messageData.appendBigEndian(static_cast<uint16_t>(data.size()));
-    messageData.append(data);
-    messageData.appendBigEndian(messageData.crc16());
+ uint32_t TuyaBLEDevice::sendMessage(TuyaBLEFunctionCode code, const Buffer& data, uint32_t responseTo, TuyaBLERequestTable::ResponseHandler onResponse, TuyaBLERequestTable::SentHandler onSent) {
+  TuyaBLERequestTable::Request request;
+  request.code = code;
+  request.responseTo = responseTo;
+  request.handler = onResponse;
+  request.onSent = onSent;
+  return sendNewRequest(request, data);
+ }
 
-    if(_isDebugLogEnabled) {
-      debugLog("[Sending] unpadded message(seq = " + String(sequenceNumber)
-        + ",  rseq = "  + String(responseTo) +
-        + ", code = " + static_cast<uint16_t>(code)
-        +  "): " 
-        + messageData.debugDescription()
-      );
-    }
+ uint32_t TuyaBLEDevice::sendNewRequest(TuyaBLERequestTable::Request& request, const Buffer& data) {
+  request.timeoutMs = _responseTimeoutMs;
 
-    messageData.padToNumberOfBytes(16);
+  // the data is only kept around if we might need to send it again
+  if(request.handler && _requestRetries > 0) {
+    request.remainingRetries = _requestRetries;
+    request.data = data;
+  }
 
-    TuyaBLESecurityFlag securityFlag = code == TuyaBLEFunctionCode::senderDeviceInfo ? TuyaBLESecurityFlag::localKey : TuyaBLESecurityFlag::sessionKey;
-    Buffer iv = Buffer::aesInitializationVector();
-    auto key = keyToUseForFlag(securityFlag);
+  return sendRequest(request, data);
+ }
+
+ void TuyaBLEDevice::beginSending() {
+  xSemaphoreTakeRecursive(_sendMutex, portMAX_DELAY);
+  _sendingDepth += 1;
+ }
 
-    Buffer encryptedMessage;
-    encryptedMessage.append(static_cast<uint8_t>(securityFlag));
-    encryptedMessage.append(iv);
-    encryptedMessage.append(messageData.aesCbc128Encrypt(key, iv));
+ void TuyaBLEDevice::endSending() {
+  // only the outermost call runs the deferred callbacks, once nothing on this task holds the lock anymore
+  std::vector<std::function<void()>> callbacks;
+  _sendingDepth -= 1;
+  if(_sendingDepth == 0)
+    callbacks.swap(_deferredSendCallbacks);
+  xSemaphoreGiveRecursive(_sendMutex);
 
-    return encryptedMessage;
+  for(auto&& callback : callbacks)
+    callback();
  }
 
- void TuyaBLEDevice::sendMessage(TuyaBLEFunctionCode code, const Buffer& data, uint32_t responseTo, bool expectsResponse) {
+ void TuyaBLEDevice::runAfterSending(std::function<void()> callback) {
+  // from outside a send, e.g. the sender task completing a message, this runs `callback` right away
+  beginSending();
+  _deferredSendCallbacks.push_back(callback);
+  endSending();
+ }
+
+ uint32_t TuyaBLEDevice::sendRequest(TuyaBLERequestTable::Request& request, const BufferView& data) {
+  // requests are sent by the caller's task and retried by the sender task,
+  // so assigning a sequence number and encoding happen under a lock
+  beginSending();
+
   _messageSequenceNumber++;
-  Buffer message = createMessage(code, data, _messageSequenceNumber, responseTo);
+  uint32_t sequenceNumber = _messageSequenceNumber;
+  TuyaBLEFunctionCode code = request.code;
+  uint32_t responseTo = request.responseTo;
+  request.sequenceNumber = sequenceNumber;
+
+  // the request is registered before it's queued, since the response might arrive before we return.
+  // Its entry also keeps what's needed once the message went out, the queue only hands back the sequence number
+  bool isTracked = request.handler || request.onSent;
+  if(isTracked && !_requests.add(request, millis())) {
+    _statistics.failedMessages += 1;
+    debugLog("[Error] too many requests in flight, not sending seq = " + String(sequenceNumber));
+
+    runAfterSending([this, request]() {
+      if(request.handler)
+        request.handler(TuyaBLERequestStatus::failed, nullptr, request);
+      if(request.onSent)
+        request.onSent(this, false);
+    });
+    endSending();
+    return 0;
+  }
 
-  std::vector<Buffer> packets = splitIntoPackets(message);
-  for(auto&& packet : packets) {
-    if(_writeCharacteristic->writeValue(packet.data(), packet.size(), false) == false) {
-      debugLog("[Error] could not send packet");
-    }
+  TuyaBLESecurityFlag securityFlag = code == TuyaBLEFunctionCode::senderDeviceInfo ? TuyaBLESecurityFlag::localKey : TuyaBLESecurityFlag::sessionKey;
+  const AesCbc128Key* key = keyToUseForFlag(securityFlag);
+  if(key == nullptr) {
+    debugLog("[Error] no key to encrypt message with, is the session established?");
   }
 
-  if(expectsResponse == true) {
-    clearExpectedResponse();
-    _waitingOnResponseSequenceNumber = _messageSequenceNumber;
+  if(_isDebugLogEnabled) {
+    debugLog("[Sending] message(seq = " + String(sequenceNumber)
+      + ",  rseq = "  + String(responseTo) +
+      + ", code = " + static_cast<uint16_t>(code)
+      +  "): " 
+      + data.debugDescription()
+    );
   }
- }
 
- std::vector<Buffer> TuyaBLEDevice::splitIntoPackets(const Buffer& data) {
-    std::vector<Buffer> packets;
-    // we can only send 20 bytes per package, so we need to split our message into packets
-    
-    // format:
-    // N|L|V|D...D
-    // N+1|D...D
-    // N+2|D...D
-    //
-    // N = packet number, a packed int
-    // L = length of the message data we're splitting into packages (only set in the first package), a packed int
-    // V = protocol version << 4 (currently 3 << 4)
-    // D = data, the length must be so that the total package size <= 20 bytes
-
-
-    size_t position = 0;
-    size_t length = data.size();
-    unsigned int packetNumber = 0;
-
-    const size_t maximumGattMtuLength = 20;
-
-    while(position < length) {
-        Buffer packet;
-        packet.appendPackedInt(packetNumber);
-        
-        if(packetNumber == 0) {
-            packet.appendPackedInt(length);
-            packet.append(_deviceInfo.protocolVersion() << 4);
-        }
-
-        size_t dataLength = std::min(maximumGattMtuLength - packet.size(), length - position);
-        packet.append(data, position, dataLength);
-        packets.push_back(packet);
-
-        packetNumber++;
-        position += dataLength;
-    }
+  uint8_t iv[TuyaBLEFrameEncoder::ivLength];
+  _randomPool.fill(iv, sizeof(iv));
+
+  // the message is encoded straight into the transmit queue, as a single buffer holding all its packets
+  uint8_t protocolVersion = _deviceInfo.protocolVersion();
+  size_t maximumPacketLength = _maximumPacketLength;
+  bool isQueued = key != nullptr && _transmitQueue.enqueue([&](TuyaBLEEncodedFrame& frame) {
+    TuyaBLEFrameEncoder::encode(frame, securityFlag, *key, iv, sequenceNumber, responseTo, code, data, protocolVersion, maximumPacketLength);
+  }, sequenceNumber);
+
+  // while the packets go out, top up the random pool for the next message
+  _randomPool.refillIfBelow(randomPoolRefillThreshold);
+
+  if(!isQueued) {
+    _statistics.failedMessages += 1;
+    debugLog("[Error] could not queue message seq = " + String(sequenceNumber));
+    runAfterSending([this, sequenceNumber]() {
+      finishSentRequest(sequenceNumber, false, TuyaBLERequestStatus::failed);
+    });
+    sequenceNumber = 0;
+  }
 
-    return packets;
+  endSending();
+  return sequenceNumber;
  }
 
+void TuyaBLEDevice::handleSentMessage(uint32_t sequenceNumber, bool success) {
+  if(success) {
+    _statistics.sentMessages += 1;
+  } else {
+    _statistics.failedMessages += 1;
+    debugLog("[Error] could not send message seq = " + String(sequenceNumber));
+  }
+  if(success && !_requests.hasSentHandler(sequenceNumber))
+    return;
+
+  // usually called on the sender task, but on ours, in the middle of sending, when the queue has no task
+  // of its own. The queue only fails messages on its own when it's stopped, which happens when we disconnect
+  TuyaBLERequestStatus status = _transmitQueue.isRunning() ? TuyaBLERequestStatus::failed : TuyaBLERequestStatus::disconnected;
+  runAfterSending([this, sequenceNumber, success, status]() {
+    finishSentRequest(sequenceNumber, success, status);
+  });
+}
+
+void TuyaBLEDevice::finishSentRequest(uint32_t sequenceNumber, bool success, TuyaBLERequestStatus status) {
+  TuyaBLERequestTable::SentHandler onSent;
+  _requests.takeSentHandler(sequenceNumber, onSent);
+  if(!success)
+    _requests.fail(sequenceNumber, status);
+  if(onSent)
+    onSent(this, success);
+}
+
+void TuyaBLEDevice::serviceRequests() {
+  TuyaBLERequestTable::Request expired;
+  while(_requests.takeExpired(millis(), expired)) {
+    if(expired.remainingRetries > 0 && _transmitQueue.isRunning()) {
+      // sent again as a new message, with a new sequence number
+      expired.remainingRetries -= 1;
+      _statistics.retriedRequests += 1;
+      if(_isDebugLogEnabled)
+        debugLog("[Error] no response to seq = " + String(expired.sequenceNumber) + ", retrying");
+
+      Buffer data = expired.data;
+      sendRequest(expired, data);
+    } else {
+      _statistics.timedOutRequests += 1;
+      if(_isDebugLogEnabled)
+        debugLog("[Error] no response to seq = " + String(expired.sequenceNumber) + ", giving up");
+
+      if(expired.handler)
+        expired.handler(TuyaBLERequestStatus::timeout, nullptr, expired);
+    }
+  }
+}
+
 void TuyaBLEDevice::sendDeviceInfoRequest() {
-		sendMessage(TuyaBLEFunctionCode::senderDeviceInfo, Buffer(), 0, true);
+		sendMessage(TuyaBLEFunctionCode::senderDeviceInfo, Buffer(), 0, [this](TuyaBLERequestStatus status, const TuyaBLEReceivedMessage* response, const TuyaBLERequestTable::Request&) {
+      if(status == TuyaBLERequestStatus::success)
+        handleReceivedResponseSenderDeviceInfo(*response);
+    });
 
 }
 
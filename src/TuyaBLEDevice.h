@@ -7,8 +7,19 @@
 #include "TuyaDeviceCredentials.h"
 #include "TuyaBLEConstants.h"
 #include "TuyaDataPoint.h"
+#include "TuyaDataPointStore.h"
+#include "TuyaDataPointSchema.h"
 #include "TuyaBLEAdvertisedDeviceInfo.h"
 #include "Buffer.h"
+#include "BufferView.h"
+#include "BufferArena.h"
+#include "TuyaBLECryptoContext.h"
+#include "TuyaBLEDeviceStatistics.h"
+#include "RandomPool.h"
+#include "TuyaBLETransmitQueue.h"
+#include "TuyaBLEMessageReassembler.h"
+#include "TuyaBLERequestTable.h"
+#include "TuyaBLEReceivedMessage.h"
 
 #include <vector>
 #include <memory>
@@ -16,8 +27,11 @@
 class NimBLEClient;
 class NimBLERemoteService;
 class NimBLERemoteCharacteristic;
-class TuyaBLEReceivedMessage;
 class TuyaBLEAdvertisedDeviceInfo;
+class TuyaBLEDevice;
+
+/// returns the current time in milliseconds since the unix epoch, or 0 if it isn't known
+typedef std::function<uint64_t()> TuyaBLETimeSource;
 
 class TuyaBLEDevice {
 private:
@@ -38,15 +52,61 @@ private:
     bool _isConnected = false;
     bool _isReady = false;
     uint32_t _messageSequenceNumber = 0;
-    uint32_t _waitingOnResponseSequenceNumber = 0;
-    uint32_t _expectedResponseDataLength = 0;
-    uint32_t _expectedResponsePacketNumber = 0;
-    Buffer _receivedData;
+
+    /// packets are added on the BLE host task, stale partial messages are expired from the sender task
+    TuyaBLEMessageReassembler _reassembler;
+    SemaphoreHandle_t _receiveMutex = xSemaphoreCreateMutex();
+
+    /// requests waiting on a response. If none arrives within `_responseTimeoutMs`, a request is sent again
+    /// up to `_requestRetries` times before it times out. Deadlines are checked from the sender task.
+    static const unsigned long defaultResponseTimeoutMs = 5000;
+    static const uint32_t requestServiceIntervalMs = 50;
+    unsigned long _responseTimeoutMs = defaultResponseTimeoutMs;
+    uint8_t _requestRetries = 0;
+    TuyaBLERequestTable _requests;
+
+    /// sending is done while holding `_sendMutex`, through `beginSending()` and `endSending()`. Callbacks of sends
+    /// that fail while it's held are deferred until the outermost `endSending()` has released it: a callback
+    /// that disconnects waits on the sender task, which might itself be waiting on `_sendMutex`.
+    SemaphoreHandle_t _sendMutex = xSemaphoreCreateRecursiveMutex();
+    uint32_t _sendingDepth = 0;
+    std::vector<std::function<void()>> _deferredSendCallbacks;
+
+    /// datapoint writes waiting to be sent as a single message, guarded by `_sendMutex`. They're sent
+    /// `_dataPointCoalescingWindowMs` after the first of them, or as soon as there are too many.
+    static const size_t maximumNumberOfCoalescedDataPoints = 32;
+    uint32_t _dataPointCoalescingWindowMs = 0;
+    std::vector<TuyaDataPoint> _coalescedDataPoints;
+    std::vector<TuyaBLEStatusCallback> _coalescedCallbacks;
+    uint32_t _numberOfCoalescedWrites = 0;
+    unsigned long _coalescingStartTime = 0;
+
+    /// we ask for a larger ATT MTU when connecting, so a message needs fewer packets. Devices that refuse
+    /// stay at the default ATT MTU of 23, which leaves 20 bytes per packet after the 3 byte ATT header
+    static const uint16_t defaultPreferredMtu = 247;
+    static const uint16_t attHeaderLength = 3;
+    static const size_t minimumPacketLength = 20;
+    uint16_t _preferredMtu = defaultPreferredMtu;
+    size_t _maximumPacketLength = minimumPacketLength;
+
+    /// short-lived buffers for decoding and encoding a single message live in these arenas, so
+    /// handling a message doesn't go to the heap once the arenas have been allocated
+    static const size_t receiveArenaCapacity = 1024;
+    static const size_t sendArenaCapacity = 512;
+    BufferArena _receiveArena{receiveArenaCapacity};
+    BufferArena _sendArena{sendArenaCapacity};
+
+    /// IVs for outbound messages are taken from this pool, which is refilled after sending
+    /// once fewer than `randomPoolRefillThreshold` bytes are left
+    static const size_t randomPoolRefillThreshold = 64;
+    RandomPool _randomPool;
+
+    /// packets are written by the transmit queue's task, so sending doesn't block the caller
+    TuyaBLETransmitQueue _transmitQueue;
 
     /// keys to use
     Buffer _localKeyFirstSixBytes;
-    Buffer _localKeyMD5;
-    Buffer _sessionKey;
+    TuyaBLECryptoContext _crypto;
 
     // device info
     String _infoDeviceVersion;
@@ -54,16 +114,56 @@ private:
     String _infoHardwareVersion;
 
     // datapoints
-    std::map<uint8_t, TuyaDataPoint> _reportedDataPoints;
-    std::map<uint32_t, std::function<void(TuyaBLEDevice*)>> _waitingOnResponseSendDpsCallbacks;
+    TuyaDataPointStore _reportedDataPoints;
+
+    /// subscriptions to changes of single datapoints. Subscriptions removed while they're being
+    /// called only lose their callback, they're removed once all subscriptions have been called
+    struct DataPointSubscription {
+        uint32_t token;
+        uint8_t dp;
+        std::function<void(TuyaBLEDevice*, const TuyaDataPoint&)> callback;
+    };
+    std::vector<DataPointSubscription> _dataPointSubscriptions;
+    TuyaDataPointIdSet _subscribedDataPoints;
+    uint32_t _lastSubscriptionToken = 0;
+    bool _isCallingSubscriptions = false;
+
+    /// the datapoints that changed in the report being handled
+    TuyaDataPointIdSet _changedDataPoints;
+
+    // traffic counters
+    TuyaBLEDeviceStatistics _statistics;
+
+    /// devices ask for the time, we answer from `_timeSource` and don't answer when it doesn't know the time
+    static const time_t minimumValidUnixTime = 1577836800; // 2020-01-01
+    TuyaBLETimeSource _timeSource = &TuyaBLEDevice::systemTimeMs;
+    int16_t _timeZoneOffsetMinutes = 0;
 
     // debug logging
     bool _isDebugLogEnabled = false;
 
-    Buffer createMessage(TuyaBLEFunctionCode code, const Buffer& data, uint32_t sequenceNumber, uint32_t responseTo);
-    std::vector<Buffer> splitIntoPackets(const Buffer& data);
-    Buffer keyToUseForFlag(TuyaBLESecurityFlag flag);
-    Buffer ensureLocalKeyMD5();
+    const AesCbc128Key* keyToUseForFlag(TuyaBLESecurityFlag flag);
+    void ensureLocalKey();
+    void updateMaximumPacketLength();
+
+    // requests
+    void beginSending();
+    void endSending();
+    void runAfterSending(std::function<void()> callback);
+    uint32_t sendNewRequest(TuyaBLERequestTable::Request& request, const Buffer& data);
+    uint32_t sendRequest(TuyaBLERequestTable::Request& request, const BufferView& data);
+    void handleSentMessage(uint32_t sequenceNumber, bool success);
+    void finishSentRequest(uint32_t sequenceNumber, bool success, TuyaBLERequestStatus status);
+    void serviceRequests();
+    void serviceTimers();
+    uint32_t timerServiceIntervalMs() const;
+
+    // datapoints
+    void sendDataPoints(const TuyaDataPoint* dps, size_t numberOfDataPoints, std::function<void(TuyaBLEDevice*)> callback);
+    void sendDataPointsWithStatus(const TuyaDataPoint* dps, size_t numberOfDataPoints, TuyaBLEStatusCallback callback);
+    void coalesceDataPoints(const TuyaDataPoint* dps, size_t numberOfDataPoints, TuyaBLEStatusCallback callback);
+    void failCoalescedDataPoints(TuyaBLERequestStatus status);
+    void transmitDataPoints(const TuyaDataPoint* dps, size_t numberOfDataPoints, std::vector<TuyaBLEStatusCallback>& callbacks);
 
     // creating a session
     void sendDeviceInfoRequest();
@@ -71,35 +171,51 @@ private:
 
     // handling received data
     void onNotify(NimBLERemoteCharacteristic* characteristic, uint8_t* data, size_t length, bool isNotify);
-    void handleReceivedMessageData(const Buffer& data);
-    void parseAndHandleReceivedMessage(const Buffer& data);
+    void handleReceivedMessageData(Buffer& data);
+    void parseAndHandleReceivedMessage(const BufferView& data);
+    void rejectReceivedFrame(TuyaBLEFrameRejectionReason reason);
     void handleReceivedFunction(const TuyaBLEReceivedMessage& message);
-    void clearExpectedResponse();
     
     // handle decoded responses
     void handleReceivedResponseSenderDeviceInfo(const TuyaBLEReceivedMessage& message);
     void handleReceivedResponseSenderPair(const TuyaBLEReceivedMessage& message);
-    void handleReceivedResponseSenderDps(const TuyaBLEReceivedMessage& message);
     void handleReceivedRequestReceiveTime1Req(const TuyaBLEReceivedMessage& message);
-    void handleReceivedReceiveDP(const TuyaBLEReceivedMessage& message);
+    void handleReceivedRequestReceiveTime2Req(const TuyaBLEReceivedMessage& message);
+    bool currentTimeMs(uint64_t& timeMs);
+    int16_t timeZoneForResponse() const;
+    void handleReceivedDataPointReport(const TuyaBLEReceivedMessage& message);
+    bool handleReceivedDataPoints(const BufferView& data, size_t numberOfLengthBytes);
+    void callDataPointSubscriptions(const TuyaDataPoint& dataPoint);
+    void removeUnsubscribedDataPointSubscriptions();
+    bool handleReceivedTimestampedDataPoints(const BufferView& data, size_t numberOfLengthBytes, uint64_t timestampMs);
 
     // callbacks
     std::function<void(TuyaBLEDevice*)> _onConnectedCallback;
     std::function<void(TuyaBLEDevice*)> _onDisconnectedCallback;
     std::function<void(TuyaBLEDevice*)> _onReadyCallback;
     std::function<void(TuyaBLEDevice*, const TuyaDataPoint&)> _onReceivedDataPointCallback;
+    std::function<void(TuyaBLEDevice*, const TuyaDataPointIdSet&)> _onChangedDataPointsCallback;
     std::function<void(TuyaBLEDevice*)> _onUpdatedReportedDataPointsCallback;
+    std::function<void(TuyaBLEDevice*, uint64_t, const std::vector<TuyaDataPoint>&)> _onReceivedTimestampedDataPointsCallback;
+    std::function<void(TuyaBLEDevice*, TuyaBLEFrameRejectionReason)> _onRejectedFrameCallback;
     std::function<void(TuyaBLEDevice*, const String&)> _onDebugLogCallback;
 
     // for use in default arguments
     static const String emptyString;
 
 protected:
-    // this sends a raw message to the device
-    void sendMessage(TuyaBLEFunctionCode code, const Buffer& data, uint32_t responseTo, bool expectsResponse);
+    // this queues a raw message for sending to the device and returns right away with its sequence number,
+    // or 0 if it couldn't be queued. `onResponse` is called exactly once: with the message that responds to it,
+    // or with why there is none (timeout, disconnected, failed). `onSent` is called on the sender task with `true`
+    // once all packets have been written, or `false` if the message couldn't be sent
+    uint32_t sendMessage(TuyaBLEFunctionCode code, const Buffer& data, uint32_t responseTo = 0, TuyaBLERequestTable::ResponseHandler onResponse = nullptr, TuyaBLERequestTable::SentHandler onSent = nullptr);
 
     // called when disconnecting
     virtual void onDisconnect();
+
+    // called for every reported datapoint, before it's stored. Device profiles decode the datapoints of their
+    // `TuyaDPSchema` into its typed storage here. Only datapoints this returns `notInSchema` for go into the generic store
+    virtual TuyaDPDecodeResult decodeReportedDataPoint(const TuyaDataPoint&) { return TuyaDPDecodeResult::notInSchema; }
 public:
     TuyaBLEDevice(TuyaBLEAdvertisedDeviceInfo info,const TuyaDeviceCredentials& credentials ) : _deviceInfo(info), _credentials(credentials) {}
     TuyaBLEDevice(const NimBLEAddress& address, const TuyaDeviceCredentials& credentials, uint8_t protocolVersion = 3) : _credentials(credentials) {
@@ -115,6 +231,8 @@ public:
     const NimBLEAddress& address() const { return _deviceInfo.address(); }
     bool isBound() const { return _deviceInfo.isBound(); }
     uint8_t protocolVersion() const { return _deviceInfo.protocolVersion(); }
+    /// devices advertising protocol v4 or later get datapoints with `senderDpsV4`
+    bool usesDataPointsV4() const { return _deviceInfo.protocolVersion() >= 4; }
     uint8_t encryptionMethod() const { return _deviceInfo.encryptionMethod(); }
     uint16_t communicationCapacity() const { return _deviceInfo.communicationCapacity(); }
     String uuid() const { return _deviceInfo.uuid(); }
@@ -125,55 +243,132 @@ public:
     bool isConnected() const { return _client != nullptr && _client->isConnected(); };
     bool isReady() const { return _isReady; }
 
-    // checking received dps
+    // mtu
+    /// the ATT MTU to ask for on the next `connect()`, the device may settle on a lower one
+    void setPreferredMtu(uint16_t mtu) { _preferredMtu = mtu; }
+    uint16_t preferredMtu() const { return _preferredMtu; }
+    /// the number of bytes we put in a single write, based on the negotiated MTU
+    size_t maximumPacketLength() const { return _maximumPacketLength; }
+
+    // sending
+    /// how long a request waits for its response
+    void setResponseTimeout(unsigned long timeoutMs) { _responseTimeoutMs = timeoutMs; }
+    unsigned long responseTimeout() const { return _responseTimeoutMs; }
+    /// how many times a request without a response is sent again, with a new sequence number, before it times out.
+    /// Only use this for requests that are safe to repeat
+    void setRequestRetries(uint8_t retries) { _requestRetries = retries; }
+    uint8_t requestRetries() const { return _requestRetries; }
+
+    /// the time devices get when they ask for it. By default the system time, which only counts once
+    /// it has been set (e.g. with `configTime()`), before that time requests aren't answered
+    void setTimeSource(TuyaBLETimeSource source) { _timeSource = source; }
+    static uint64_t systemTimeMs();
+    /// the offset of local time to UTC, devices get local time and the offset
+    void setTimeZoneOffset(int16_t offsetMinutes) { _timeZoneOffsetMinutes = offsetMinutes; }
+    int16_t timeZoneOffset() const { return _timeZoneOffsetMinutes; }
+    /// queue size, pacing and retries for outbound packets, applied on the next `connect()`
+    void setTransmitConfiguration(const TuyaBLETransmitQueue::Configuration& configuration) { _transmitQueue.setConfiguration(configuration); }
+    const TuyaBLETransmitQueue::Configuration& transmitConfiguration() const { return _transmitQueue.configuration(); }
+
+    // checking received dps. Device profiles keep the datapoints of their schema out of these, in typed
+    // storage, see `decodeReportedDataPoint()`
     void requestDataPointsUpdate();
-    bool hasDataPoint(uint8_t dp) const { return _reportedDataPoints.find(dp) != _reportedDataPoints.end(); }
+    bool hasDataPoint(uint8_t dp) const { return _reportedDataPoints.contains(dp); }
     const TuyaDataPoint& reportedDataPoint(uint8_t dp) const { 
-        auto iter = _reportedDataPoints.find(dp);
-        return iter == _reportedDataPoints.end() ? TuyaDataPoint::invalid : iter->second;
+        const TuyaDataPoint* dataPoint = _reportedDataPoints.find(dp);
+        return dataPoint == nullptr ? TuyaDataPoint::invalid : *dataPoint;
     }
-    const std::map<uint8_t, TuyaDataPoint> reportedDataPoints() const { return _reportedDataPoints; }
+    /// all reported datapoints, without copying them. Prefer this or `forEachReportedDataPoint()`
+    /// over `reportedDataPoints()`, which copies every datapoint into a new map
+    const TuyaDataPointStore& reportedDataPointStore() const { return _reportedDataPoints; }
+    template<typename Visitor>
+    void forEachReportedDataPoint(Visitor visitor) const { _reportedDataPoints.forEach(visitor); }
+    std::map<uint8_t, TuyaDataPoint> reportedDataPoints() const { return _reportedDataPoints.toMap(); }
 
-    const Buffer& reportedRawDataPoint(uint8_t dp, const Buffer& defaultValue = Buffer::empty) const { 
-        auto value = reportedDataPoint(dp);
-        return value.isValid() ? value.raw() : defaultValue;
+    // typed access to reported datapoints: these read the stored datapoint in place and return
+    // `defaultValue` if there is none or it has another type. Views stay valid until the same datapoint is reported
+    // again: stored datapoints never move, so reports of other datapoints don't affect them
+    BufferView reportedRawDataPoint(uint8_t dp, const BufferView& defaultValue = BufferView()) const { 
+        const TuyaDataPoint* value = _reportedDataPoints.find(dp, TuyaDataPointType::raw);
+        return value != nullptr ? value->raw() : defaultValue;
     }
 
     bool reportedBooleanDataPoint(uint8_t dp, bool defaultValue = false) const { 
-        auto value = reportedDataPoint(dp);
-        return value.isValid() ? value.boolean() : defaultValue;
+        const TuyaDataPoint* value = _reportedDataPoints.find(dp, TuyaDataPointType::boolean);
+        return value != nullptr ? value->boolean() : defaultValue;
     }
 
     int32_t reportedValueDataPoint(uint8_t dp, int32_t defaultValue = 0) const { 
-        auto value = reportedDataPoint(dp);
-        return value.isValid()? value.value() : defaultValue;
+        const TuyaDataPoint* value = _reportedDataPoints.find(dp, TuyaDataPointType::value);
+        return value != nullptr ? value->value() : defaultValue;
     }
 
-    const String& reportedStringDataPoint(uint8_t dp, const String& defaultValue = TuyaBLEDevice::emptyString) const { 
-        auto value = reportedDataPoint(dp);
-        return value.isValid() ? value.string() : defaultValue;
+    String reportedStringDataPoint(uint8_t dp, const String& defaultValue = TuyaBLEDevice::emptyString) const { 
+        const TuyaDataPoint* value = _reportedDataPoints.find(dp, TuyaDataPointType::string);
+        return value != nullptr ? value->string() : defaultValue;
+    }
+
+    /// the bytes of a string datapoint, without copying them into a `String`. They're not zero terminated
+    BufferView reportedStringDataPointView(uint8_t dp, const BufferView& defaultValue = BufferView()) const { 
+        const TuyaDataPoint* value = _reportedDataPoints.find(dp, TuyaDataPointType::string);
+        return value != nullptr ? value->payload() : defaultValue;
     }
 
     uint8_t reportedEnumerationDataPoint(uint8_t dp, uint8_t defaultValue = 0) const { 
-        auto value = reportedDataPoint(dp);
-        return value.isValid() ? value.enumeration() : defaultValue;
+        const TuyaDataPoint* value = _reportedDataPoints.find(dp, TuyaDataPointType::enumeration);
+        return value != nullptr ? value->enumeration() : defaultValue;
     }
 
-    const Buffer& reportedBitmapDataPoint(uint8_t dp, const Buffer& defaultValue = Buffer::empty) const { 
-        auto value = reportedDataPoint(dp);
-        return value.isValid() ? value.bitmap() : defaultValue;
+    BufferView reportedBitmapDataPoint(uint8_t dp, const BufferView& defaultValue = BufferView()) const { 
+        const TuyaDataPoint* value = _reportedDataPoints.find(dp, TuyaDataPointType::bitmap);
+        return value != nullptr ? value->bitmap() : defaultValue;
     }
 
     // sending dps
+    // the plain callback is only called when the device confirmed the datapoints, the status callback
+    // is always called: when confirmed, or on timeout, disconnect or failure to send
     void sendDataPoints(const std::vector<TuyaDataPoint>& dps, std::function<void(TuyaBLEDevice*)> callback = nullptr);
+    void sendDataPointsWithStatus(const std::vector<TuyaDataPoint>& dps, TuyaBLEStatusCallback callback);
     void sendDataPoint(const TuyaDataPoint& dp, std::function<void(TuyaBLEDevice*)> callback = nullptr);
+    void sendDataPointWithStatus(const TuyaDataPoint& dp, TuyaBLEStatusCallback callback);
+
+    /// with a window, datapoint writes aren't sent right away but collected for `windowMs` and sent as
+    /// a single message. A later write to the same datapoint replaces the pending value, and each
+    /// callback is called once the combined message completes. 0, the default, sends every write right away
+    void setDataPointCoalescingWindow(uint32_t windowMs);
+    uint32_t dataPointCoalescingWindow() const { return _dataPointCoalescingWindowMs; }
+    /// sends pending datapoint writes now, without waiting for the window to end
+    void flushDataPoints();
 
     // device callbacks
     void setOnConnectedCallback(std::function<void(TuyaBLEDevice*)> callback) { _onConnectedCallback = callback; }
     void setOnDisconnectedCallback(std::function<void(TuyaBLEDevice*)> callback) { _onDisconnectedCallback = callback; }
     void setOnReadyCallback(std::function<void(TuyaBLEDevice*)> callback) { _onReadyCallback = callback; }
     void setOnReceivedDataPointCallback(std::function<void(TuyaBLEDevice*, const TuyaDataPoint&)> callback) { _onReceivedDataPointCallback = callback; }
+    /// called once at the end of each report that changed datapoints, with the ids of those that changed.
+    /// Unlike the callbacks above, reports that only repeat known values don't call it
+    void setOnChangedDataPointsCallback(std::function<void(TuyaBLEDevice*, const TuyaDataPointIdSet& changed)> callback) { _onChangedDataPointsCallback = callback; }
+
+    /// `callback` is called whenever datapoint `dp` is reported for the first time or with another value.
+    /// Returns a token for `unsubscribeFromDataPoint()`. Don't subscribe while datapoints are being received,
+    /// except from within a callback
+    uint32_t subscribeToDataPoint(uint8_t dp, std::function<void(TuyaBLEDevice*, const TuyaDataPoint&)> callback);
+    void unsubscribeFromDataPoint(uint32_t token);
     void setOnUpdatedReportedDataPointsCallback(std::function<void(TuyaBLEDevice*)> callback) { _onUpdatedReportedDataPointsCallback = callback; }
+    /// called once per timestamped report, with all its datapoints and the time the device recorded them,
+    /// in milliseconds since the unix epoch. These datapoints are history and don't change `reportedDataPoints()`
+    void setOnReceivedTimestampedDataPointsCallback(std::function<void(TuyaBLEDevice*, uint64_t timestampMs, const std::vector<TuyaDataPoint>& dps)> callback) { _onReceivedTimestampedDataPointsCallback = callback; }
+
+    /// called when a received frame is dropped because it fails validation, e.g. to re-request
+    /// datapoints right away with `requestDataPointsUpdate()` instead of waiting for a timeout
+    void setOnRejectedFrameCallback(std::function<void(TuyaBLEDevice*, TuyaBLEFrameRejectionReason)> callback) { _onRejectedFrameCallback = callback; }
+
+    /// the source of IVs for outbound messages, seed it for reproducible ciphertext in tests
+    RandomPool& randomPool() { return _randomPool; }
+
+    // statistics
+    const TuyaBLEDeviceStatistics& statistics() const { return _statistics; }
+    void resetStatistics() { _statistics.reset(); }
 
     // debugging
     bool isDebugLogEnabled() const { return _isDebugLogEnabled; }
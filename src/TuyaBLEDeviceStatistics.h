@@ -0,0 +1,88 @@
+#ifndef TUYA_BLE_DEVICE_STATISTICS_123
+#define TUYA_BLE_DEVICE_STATISTICS_123
+
+#include <stdint.h>
+
+/// why a received frame was dropped before being dispatched
+enum class TuyaBLEFrameRejectionReason: uint8_t {
+	/// the frame is too short to hold a flag, iv and a single encrypted block,
+	/// or the encrypted part isn't a multiple of the block size
+	malformed,
+
+	/// the security flag asks for a key we don't have (yet)
+	noKey,
+
+	/// the declared data length doesn't fit in the decrypted message
+	invalidLength,
+
+	/// the crc of the decrypted message doesn't match, usually the wrong key or a corrupted packet
+	invalidCrc,
+};
+
+inline const char* TuyaBLEFrameRejectionReasonName(TuyaBLEFrameRejectionReason reason) {
+	switch(reason) {
+		case TuyaBLEFrameRejectionReason::malformed: return "malformed";
+		case TuyaBLEFrameRejectionReason::noKey: return "no key";
+		case TuyaBLEFrameRejectionReason::invalidLength: return "invalid length";
+		case TuyaBLEFrameRejectionReason::invalidCrc: return "invalid crc";
+	}
+	return "unknown";
+}
+
+/// counters for the traffic of a single device, they start at zero and are never reset by the device itself
+struct TuyaBLEDeviceStatistics {
+	/// messages that passed all checks and were dispatched
+	uint32_t receivedMessages = 0;
+
+	/// outbound messages that were written completely, and those that couldn't be queued or written
+	uint32_t sentMessages = 0;
+	uint32_t failedMessages = 0;
+
+	/// requests that got no response in time: sent again, or given up on
+	uint32_t retriedRequests = 0;
+	uint32_t timedOutRequests = 0;
+
+	/// datapoint writes that were merged into a message with other writes, instead of being sent on their own
+	uint32_t coalescedDataPointWrites = 0;
+
+	/// reported datapoints that were new or had another value than before, and those that repeated the known value
+	uint32_t changedDataPoints = 0;
+	uint32_t unchangedDataPoints = 0;
+
+	/// datapoints received with the time the device recorded them, and acknowledgements of reports we queued for sending
+	uint32_t timestampedDataPoints = 0;
+	uint32_t acknowledgedReports = 0;
+
+	/// times the device asked for the time (receiveTime1Req, receiveTime2Req), and answers we queued for sending
+	uint32_t timeRequests = 0;
+	uint32_t answeredTimeRequests = 0;
+
+	/// reassembling packets into messages: packets that were received twice, packets that were dropped
+	/// (malformed, missing the start of their message, out of order or overrunning the message),
+	/// and partial messages that were given up on, some of them because no packet arrived in time
+	uint32_t duplicatePackets = 0;
+	uint32_t ignoredPackets = 0;
+	uint32_t abandonedMessages = 0;
+	uint32_t timedOutMessages = 0;
+
+	/// frames that were dropped, in total and per reason
+	uint32_t rejectedFrames = 0;
+	uint32_t rejectedMalformedFrames = 0;
+	uint32_t rejectedNoKeyFrames = 0;
+	uint32_t rejectedInvalidLengthFrames = 0;
+	uint32_t rejectedInvalidCrcFrames = 0;
+
+	void recordRejectedFrame(TuyaBLEFrameRejectionReason reason) {
+		rejectedFrames += 1;
+		switch(reason) {
+			case TuyaBLEFrameRejectionReason::malformed: rejectedMalformedFrames += 1; break;
+			case TuyaBLEFrameRejectionReason::noKey: rejectedNoKeyFrames += 1; break;
+			case TuyaBLEFrameRejectionReason::invalidLength: rejectedInvalidLengthFrames += 1; break;
+			case TuyaBLEFrameRejectionReason::invalidCrc: rejectedInvalidCrcFrames += 1; break;
+		}
+	}
+
+	void reset() { *this = TuyaBLEDeviceStatistics(); }
+};
+
+#endif//TUYA_BLE_DEVICE_STATISTICS_123
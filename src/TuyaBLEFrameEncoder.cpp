@@ -0,0 +1,107 @@
+#include "TuyaBLEFrameEncoder.h"
+#include "Crc16.h"
+
+#include <string.h>
+#include <algorithm>
+
+static size_t packedIntLength(uint32_t value) {
+    size_t length = 1;
+    while(value >= 0x80) {
+        value >>= 7;
+        length += 1;
+    }
+    return length;
+}
+
+/// writes `value` the way `Buffer::appendPackedInt()` does, returns the number of bytes written
+static size_t writePackedInt(uint8_t* output, uint32_t value) {
+    size_t length = 0;
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if(value != 0) byte |= 0x80;
+        output[length++] = byte;
+    } while(value != 0);
+    return length;
+}
+
+static uint8_t* writeBigEndian(uint8_t* output, uint32_t value) {
+    output[0] = static_cast<uint8_t>(value >> 24);
+    output[1] = static_cast<uint8_t>(value >> 16);
+    output[2] = static_cast<uint8_t>(value >> 8);
+    output[3] = static_cast<uint8_t>(value);
+    return output + 4;
+}
+
+static uint8_t* writeBigEndian(uint8_t* output, uint16_t value) {
+    output[0] = static_cast<uint8_t>(value >> 8);
+    output[1] = static_cast<uint8_t>(value);
+    return output + 2;
+}
+
+static size_t packetHeaderLength(uint32_t packetNumber, size_t frameLength) {
+    size_t length = packedIntLength(packetNumber);
+    if(packetNumber == 0) length += packedIntLength(static_cast<uint32_t>(frameLength)) + 1;
+    return length;
+}
+
+void TuyaBLEFrameEncoder::encode(TuyaBLEEncodedFrame& output,
+    TuyaBLESecurityFlag securityFlag, const AesCbc128Key& key, const uint8_t* iv,
+    uint32_t sequenceNumber, uint32_t responseTo, TuyaBLEFunctionCode code, const BufferView& data,
+    uint8_t protocolVersion, size_t maximumPacketLength) {
+
+    const size_t frameLength = TuyaBLEFrameEncoder::frameLength(data.size());
+
+    // lay out the packets first, so we know how many header bytes go in front of the frame
+    output.clear();
+    size_t totalLength = 0;
+    for(size_t position = 0; position < frameLength; ) {
+        uint32_t packetNumber = static_cast<uint32_t>(output._packetEnds.size());
+        size_t headerLength = packetHeaderLength(packetNumber, frameLength);
+        size_t dataLength = std::min(maximumPacketLength - headerLength, frameLength - position);
+        totalLength += headerLength + dataLength;
+        position += dataLength;
+        output._packetEnds.push_back(static_cast<uint32_t>(totalLength));
+    }
+
+    output._bytes.resize(totalLength);
+    uint8_t* bytes = output._bytes.data();
+
+    // the frame goes at the end, leaving room for all packet headers in front of it
+    uint8_t* frame = bytes + totalLength - frameLength;
+    frame[0] = static_cast<uint8_t>(securityFlag);
+    memcpy(frame + 1, iv, ivLength);
+
+    // the crc is updated as the header and payload are written, so they're not read back afterwards
+    uint8_t* message = frame + frameHeaderLength;
+    uint8_t* cursor = message;
+    cursor = writeBigEndian(cursor, sequenceNumber);
+    cursor = writeBigEndian(cursor, responseTo);
+    cursor = writeBigEndian(cursor, static_cast<uint16_t>(code));
+    cursor = writeBigEndian(cursor, static_cast<uint16_t>(data.size()));
+    Crc16 crc;
+    crc.update(message, cursor - message);
+    crc.copyAndUpdate(cursor, data.data(), data.size());
+    cursor += data.size();
+    cursor = writeBigEndian(cursor, crc.value());
+    memset(cursor, 0, frame + frameLength - cursor);
+
+    key.encryptInPlace(iv, message, frameLength - frameHeaderLength);
+
+    // move the frame forward packet by packet, writing the headers in between. We never write past
+    // the part of the frame we still have to move, since all headers that are still to come fit in front of it
+    const uint8_t* source = frame;
+    uint8_t* destination = bytes;
+    for(size_t packetNumber = 0; packetNumber < output._packetEnds.size(); packetNumber++) {
+        destination += writePackedInt(destination, static_cast<uint32_t>(packetNumber));
+        if(packetNumber == 0) {
+            destination += writePackedInt(destination, static_cast<uint32_t>(frameLength));
+            *destination++ = static_cast<uint8_t>(protocolVersion << 4);
+        }
+
+        size_t dataLength = bytes + output._packetEnds[packetNumber] - destination;
+        memmove(destination, source, dataLength);
+        destination += dataLength;
+        source += dataLength;
+    }
+}
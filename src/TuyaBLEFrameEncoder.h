@@ -0,0 +1,77 @@
+#ifndef TUYA_BLE_FRAME_ENCODER_123
+#define TUYA_BLE_FRAME_ENCODER_123
+
+#include <Arduino.h>
+#include <vector>
+
+#include "Buffer.h"
+#include "BufferView.h"
+#include "CryptoHelper.h"
+#include "TuyaBLEConstants.h"
+
+/// An encoded outbound message, ready to be written: its packets back to back in a single buffer.
+/// Clearing it keeps the capacity, so a frame that is reused doesn't allocate once it's large enough.
+class TuyaBLEEncodedFrame {
+private:
+    Buffer _bytes;
+    std::vector<uint32_t> _packetEnds;
+
+    friend class TuyaBLEFrameEncoder;
+
+public:
+    void clear() {
+        _bytes.clear();
+        _packetEnds.clear();
+    }
+
+    bool isEmpty() const { return _packetEnds.empty(); }
+    size_t numberOfPackets() const { return _packetEnds.size(); }
+
+    /// a view on the bytes of a single packet, valid until the frame is cleared or encoded into again
+    BufferView packet(size_t index) const {
+        size_t start = index == 0 ? 0 : _packetEnds[index - 1];
+        return BufferView(_bytes.data() + start, _packetEnds[index] - start);
+    }
+
+    /// all packets, back to back
+    const Buffer& bytes() const { return _bytes; }
+};
+
+/// Encodes an outbound message into its packets in a single pass over a single buffer.
+///
+/// A message is sent as a frame, which is split into packets:
+///
+///   frame:   F|IIIIIIIIIIIIIIII|SSSS|RRRR|CC|LL|D...D|XX|PP..PP
+///                              |---------- encrypted ----------|
+///   packets: N|L|V|D...D, N+1|D...D, N+2|D...D, ...
+///
+/// F = security flag, I = IV, S = sequence number, R = sequence number this responds to, C = function code,
+/// L = data length, D = data, X = crc16 of SSSS..D, P = zero padding to a multiple of 16 bytes.
+/// N = packet number (packed int), L = frame length (packed int), V = protocol version << 4, only in packet 0.
+///
+/// Since the size of the frame is known up front, the packet layout is too. The frame is written at the end
+/// of the output, encrypted in place, and then moved forward packet by packet to make room for the headers.
+class TuyaBLEFrameEncoder {
+public:
+    static const size_t ivLength = 16;
+    static const size_t frameHeaderLength = 1 + ivLength;
+    static const size_t messageHeaderLength = 4 + 4 + 2 + 2;
+    static const size_t crcLength = 2;
+
+    /// length of the encrypted part of a frame with `dataLength` bytes of data
+    static size_t encryptedLength(size_t dataLength) {
+        return (messageHeaderLength + dataLength + crcLength + 15) & ~size_t(15);
+    }
+
+    static size_t frameLength(size_t dataLength) {
+        return frameHeaderLength + encryptedLength(dataLength);
+    }
+
+    /// encodes a message into `output`, in packets of at most `maximumPacketLength` bytes
+    static void encode(TuyaBLEEncodedFrame& output,
+        TuyaBLESecurityFlag securityFlag, const AesCbc128Key& key, const uint8_t* iv,
+        uint32_t sequenceNumber, uint32_t responseTo, TuyaBLEFunctionCode code, const BufferView& data,
+        uint8_t protocolVersion, size_t maximumPacketLength);
+};
+
+#endif//TUYA_BLE_FRAME_ENCODER_123
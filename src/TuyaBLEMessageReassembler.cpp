@@ -0,0 +1,116 @@
+#include "TuyaBLEMessageReassembler.h"
+#include "ByteReader.h"
+
+#include <string.h>
+
+/// A parsed received packet, its data points into the packet
+struct TuyaBLEReceivedPacket {
+    bool isValid = false;
+    uint32_t packetNumber = 0;
+    uint32_t messageLength = 0;
+    uint8_t protocolVersion = 0;
+    BufferView data;
+
+    static TuyaBLEReceivedPacket fromData(const BufferView& data) {
+        TuyaBLEReceivedPacket parsedPacket;
+
+        ByteReader reader(data);
+        parsedPacket.packetNumber = reader.readPackedInt();
+        if(parsedPacket.packetNumber == 0) {
+            parsedPacket.messageLength = reader.readPackedInt();
+            parsedPacket.protocolVersion = reader.readUint8() >> 4;
+        }
+
+        parsedPacket.data = reader.readRemaining();
+        parsedPacket.isValid = reader.isValid();
+        return parsedPacket;
+    }
+};
+
+void TuyaBLEMessageReassembler::reset() {
+    _isInProgress = false;
+    _nextPacketNumber = 0;
+    _messageLength = 0;
+    _firstPacketDataLength = 0;
+    _message.clear();
+}
+
+void TuyaBLEMessageReassembler::abandon(TuyaBLEDeviceStatistics& statistics) {
+    statistics.abandonedMessages += 1;
+    reset();
+}
+
+void TuyaBLEMessageReassembler::expireStaleMessage(unsigned long now, TuyaBLEDeviceStatistics& statistics) {
+    if(_isInProgress && now - _lastPacketTime > _timeoutMs) {
+        statistics.timedOutMessages += 1;
+        abandon(statistics);
+    }
+}
+
+TuyaBLEMessageReassembler::Result TuyaBLEMessageReassembler::addPacket(const BufferView& data, unsigned long now, TuyaBLEDeviceStatistics& statistics) {
+    TuyaBLEReceivedPacket packet = TuyaBLEReceivedPacket::fromData(data);
+    if(!packet.isValid) {
+        statistics.ignoredPackets += 1;
+        return Result::ignored;
+    }
+
+    expireStaleMessage(now, statistics);
+
+    if(packet.packetNumber == 0) {
+        if(_isInProgress) {
+            // the first packet again, with the same data: a repeat, not a new message
+            bool isRepeat = _nextPacketNumber == 1
+                && packet.messageLength == _messageLength
+                && packet.data.size() == _firstPacketDataLength
+                && memcmp(packet.data.data(), _message.data(), _firstPacketDataLength) == 0;
+            if(isRepeat) {
+                statistics.duplicatePackets += 1;
+                return Result::ignored;
+            }
+
+            // the device gave up on the previous message and started a new one
+            abandon(statistics);
+        }
+
+        if(packet.messageLength == 0 || packet.messageLength > maximumMessageLength) {
+            statistics.ignoredPackets += 1;
+            return Result::ignored;
+        }
+
+        _message.clear();
+        _message.reserve(packet.messageLength);
+        _messageLength = packet.messageLength;
+        _firstPacketDataLength = packet.data.size();
+        _nextPacketNumber = 0;
+        _isInProgress = true;
+    } else if(!_isInProgress) {
+        // the rest of a message we didn't see the start of, or that we abandoned
+        statistics.ignoredPackets += 1;
+        return Result::ignored;
+    } else if(packet.packetNumber < _nextPacketNumber) {
+        statistics.duplicatePackets += 1;
+        return Result::ignored;
+    } else if(packet.packetNumber > _nextPacketNumber) {
+        // we missed a packet, there's no way to get it back
+        statistics.ignoredPackets += 1;
+        abandon(statistics);
+        return Result::ignored;
+    }
+
+    if(_message.size() + packet.data.size() > _messageLength) {
+        statistics.ignoredPackets += 1;
+        abandon(statistics);
+        return Result::ignored;
+    }
+
+    _message.append(packet.data);
+    _nextPacketNumber += 1;
+    _lastPacketTime = now;
+
+    if(_message.size() < _messageLength) return Result::incomplete;
+
+    // keep the bytes for the caller, but we're ready for the next message
+    _isInProgress = false;
+    _nextPacketNumber = 0;
+    return Result::complete;
+}
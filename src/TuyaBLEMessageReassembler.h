@@ -0,0 +1,70 @@
+#ifndef TUYA_BLE_MESSAGE_REASSEMBLER_123
+#define TUYA_BLE_MESSAGE_REASSEMBLER_123
+
+#include <Arduino.h>
+
+#include "Buffer.h"
+#include "BufferView.h"
+#include "TuyaBLEDeviceStatistics.h"
+
+/// Reassembles received packets into messages.
+///
+/// A packet is N|D...D, where the first packet (N = 0) also declares the length of the
+/// message it starts: 0|L|V|D...D (see TuyaBLEFrameEncoder). Packets don't say which message they belong to,
+/// so a device sends one message at a time: a new packet 0 starts a new message, whether it's a response
+/// or an unsolicited datapoints report. Reassembly doesn't depend on what we've sent, so a report that arrives
+/// while we're waiting for a response is handled like any other message.
+///
+///  - the buffer is preallocated from the length in packet 0, and kept around for the next message
+///  - a repeated packet is ignored
+///  - a missing packet, a packet that overruns the declared length, or a gap of more than `timeoutMs`
+///    between packets abandons the partial message, which leaves us waiting for the next packet 0.
+///    The gap is checked when the next packet arrives and whenever `expireStaleMessage()` is called,
+///    which `TuyaBLEDevice` does from its sender task, so a message that stalls is dropped without waiting for another
+class TuyaBLEMessageReassembler {
+public:
+    enum class Result: uint8_t {
+        /// the packet was added, more packets are needed
+        incomplete,
+
+        /// the packet completed a message, it's available in `message()`
+        complete,
+
+        /// the packet was dropped, see the statistics for why
+        ignored,
+    };
+
+    static const size_t maximumMessageLength = 4096;
+    static const unsigned long defaultTimeoutMs = 3000;
+
+private:
+    Buffer _message;
+    bool _isInProgress = false;
+    uint32_t _nextPacketNumber = 0;
+    uint32_t _messageLength = 0;
+    size_t _firstPacketDataLength = 0;
+    unsigned long _lastPacketTime = 0;
+    unsigned long _timeoutMs = defaultTimeoutMs;
+
+    void abandon(TuyaBLEDeviceStatistics& statistics);
+
+public:
+    /// adds a packet received at `now` (in ms), counting duplicates and abandoned messages in `statistics`
+    Result addPacket(const BufferView& packet, unsigned long now, TuyaBLEDeviceStatistics& statistics);
+
+    /// abandons a partial message if its last packet is older than the timeout
+    void expireStaleMessage(unsigned long now, TuyaBLEDeviceStatistics& statistics);
+
+    /// the completed message, only valid right after `addPacket()` returned `complete`. It may be modified
+    /// (e.g. decrypted in place): it is overwritten by the next message.
+    Buffer& message() { return _message; }
+
+    /// forgets a partial message, without counting it as abandoned
+    void reset();
+
+    bool isInProgress() const { return _isInProgress; }
+    void setTimeout(unsigned long timeoutMs) { _timeoutMs = timeoutMs; }
+    unsigned long timeout() const { return _timeoutMs; }
+};
+
+#endif//TUYA_BLE_MESSAGE_REASSEMBLER_123
@@ -0,0 +1,27 @@
+#ifndef TUYA_BLE_RECEIVED_MESSAGE_123
+#define TUYA_BLE_RECEIVED_MESSAGE_123
+
+#include <Arduino.h>
+
+#include "BufferView.h"
+#include "TuyaBLEConstants.h"
+
+/// A parsed received message, its data points into the decrypted frame and is only valid while it's being handled
+class TuyaBLEReceivedMessage {
+public:
+  TuyaBLEFunctionCode functionCode;
+  uint32_t sequenceNumber = 0;
+  uint32_t responseToSequenceNumber = 0;
+  BufferView data;
+
+  String debugDescription() const {
+    String output;
+    output += "code = " + String(static_cast<uint16_t>(functionCode), HEX);
+    output += ", seq = " + String(sequenceNumber);
+    output += ", rseq = " + String(responseToSequenceNumber);
+    output += ", data = " + data.debugDescription();
+    return output;
+  }
+};
+
+#endif//TUYA_BLE_RECEIVED_MESSAGE_123
@@ -0,0 +1,142 @@
+#include "TuyaBLERequestTable.h"
+
+TuyaBLERequestTable::Entry* TuyaBLERequestTable::find(uint32_t sequenceNumber) {
+    for(size_t index = 0; index < capacity; index++) {
+        if(_entries[index].isInUse && _entries[index].request.sequenceNumber == sequenceNumber) return &_entries[index];
+    }
+    return nullptr;
+}
+
+void TuyaBLERequestTable::removeEntry(Entry& entry) {
+    _deadlines.cancel(&entry - _entries);
+    entry.isInUse = false;
+    entry.hasExpired = false;
+    entry.request.handler = nullptr;
+    entry.request.onSent = nullptr;
+    entry.request.statusCallbacks.clear();
+    entry.request.data.clear();
+    _numberOfEntries -= 1;
+}
+
+bool TuyaBLERequestTable::add(Request& request, unsigned long now) {
+    lock();
+    for(size_t index = 0; index < capacity; index++) {
+        Entry& entry = _entries[index];
+        if(entry.isInUse) continue;
+
+        entry.isInUse = true;
+        entry.hasExpired = false;
+        entry.request = std::move(request);
+        if(entry.request.handler)
+            _deadlines.schedule(index, now, now + entry.request.timeoutMs);
+        _numberOfEntries += 1;
+        unlock();
+        return true;
+    }
+
+    unlock();
+    return false;
+}
+
+bool TuyaBLERequestTable::complete(const TuyaBLEReceivedMessage& response, uint32_t responseToSequenceNumber) {
+    lock();
+    Entry* entry = find(responseToSequenceNumber);
+    if(entry == nullptr || !entry->request.handler) {
+        unlock();
+        return false;
+    }
+
+    // the handler is called without holding the lock, so it can send a new request
+    Request request = std::move(entry->request);
+    removeEntry(*entry);
+    unlock();
+
+    request.handler(TuyaBLERequestStatus::success, &response, request);
+    return true;
+}
+
+bool TuyaBLERequestTable::takeSentHandler(uint32_t sequenceNumber, SentHandler& onSent) {
+    lock();
+    Entry* entry = find(sequenceNumber);
+    if(entry == nullptr || !entry->request.onSent) {
+        unlock();
+        return false;
+    }
+
+    onSent = std::move(entry->request.onSent);
+    entry->request.onSent = nullptr;
+    if(!entry->request.handler)
+        removeEntry(*entry);
+    unlock();
+    return true;
+}
+
+bool TuyaBLERequestTable::hasSentHandler(uint32_t sequenceNumber) {
+    lock();
+    Entry* entry = find(sequenceNumber);
+    bool result = entry != nullptr && entry->request.onSent;
+    unlock();
+    return result;
+}
+
+bool TuyaBLERequestTable::fail(uint32_t sequenceNumber, TuyaBLERequestStatus status) {
+    lock();
+    Entry* entry = find(sequenceNumber);
+    if(entry == nullptr) {
+        unlock();
+        return false;
+    }
+
+    Request request = std::move(entry->request);
+    removeEntry(*entry);
+    unlock();
+
+    if(request.handler)
+        request.handler(status, nullptr, request);
+    return true;
+}
+
+void TuyaBLERequestTable::failAll(TuyaBLERequestStatus status) {
+    for(size_t index = 0; index < capacity; index++) {
+        lock();
+        Entry& entry = _entries[index];
+        if(!entry.isInUse) {
+            unlock();
+            continue;
+        }
+
+        Request request = std::move(entry.request);
+        removeEntry(entry);
+        unlock();
+
+        if(request.handler)
+            request.handler(status, nullptr, request);
+    }
+}
+
+bool TuyaBLERequestTable::takeExpired(unsigned long now, Request& expired) {
+    lock();
+    _deadlines.advance(now, [this](size_t index) {
+        _entries[index].hasExpired = true;
+    });
+
+    for(size_t index = 0; index < capacity; index++) {
+        Entry& entry = _entries[index];
+        if(!entry.isInUse || !entry.hasExpired) continue;
+
+        expired = std::move(entry.request);
+        removeEntry(entry);
+        unlock();
+        return true;
+    }
+
+    unlock();
+    return false;
+}
+
+bool TuyaBLERequestTable::contains(uint32_t sequenceNumber) {
+    lock();
+    bool result = find(sequenceNumber) != nullptr;
+    unlock();
+    return result;
+}
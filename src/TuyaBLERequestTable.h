@@ -0,0 +1,142 @@
+#ifndef TUYA_BLE_REQUEST_TABLE_123
+#define TUYA_BLE_REQUEST_TABLE_123
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <functional>
+#include <vector>
+
+#include "Buffer.h"
+#include "TuyaBLEConstants.h"
+#include "TuyaBLETimerWheel.h"
+
+class TuyaBLEReceivedMessage;
+class TuyaBLEDevice;
+
+/// how a request ended
+enum class TuyaBLERequestStatus: uint8_t {
+	/// the device responded
+	success,
+
+	/// no response arrived in time, after all retries
+	timeout,
+
+	/// the device disconnected before it responded
+	disconnected,
+
+	/// the request couldn't be sent
+	failed,
+};
+
+inline const char* TuyaBLERequestStatusName(TuyaBLERequestStatus status) {
+	switch(status) {
+		case TuyaBLERequestStatus::success: return "success";
+		case TuyaBLERequestStatus::timeout: return "timeout";
+		case TuyaBLERequestStatus::disconnected: return "disconnected";
+		case TuyaBLERequestStatus::failed: return "failed";
+	}
+	return "unknown";
+}
+
+/// called when a request to the device completes, with how it completed
+typedef std::function<void(TuyaBLEDevice*, TuyaBLERequestStatus)> TuyaBLEStatusCallback;
+
+/// The requests we sent and are waiting on a response for, keyed by their sequence number.
+/// Responses are matched by the sequence number they respond to, whatever their function code,
+/// so several requests can be in flight to the same device at once.
+///
+/// Every request with a handler has a deadline, tracked in a timer wheel. `takeExpired()` hands out requests whose
+/// deadline passed, so the owner can send them again or report the timeout. A request that only has an `onSent`
+/// handler is kept until its message went out, see `takeSentHandler()`.
+///
+/// Everything a request needs when it ends is kept in its entry, so sending one doesn't allocate
+/// for closures: its handler gets the request, with the `statusCallbacks` it carries.
+///
+/// The table has a fixed capacity. It's guarded by a lock, since requests are added by the sending task,
+/// completed by the task that receives notifications and expire on the task that services the timers.
+/// Handlers are always called without holding the lock.
+class TuyaBLERequestTable {
+public:
+    struct Request;
+
+    /// `response` is only set when `status` is success, `request` is the request that ended
+    typedef std::function<void(TuyaBLERequestStatus status, const TuyaBLEReceivedMessage* response, const Request& request)> ResponseHandler;
+
+    /// called once the message of a request went out, or with false when it couldn't be sent
+    typedef std::function<void(TuyaBLEDevice* device, bool success)> SentHandler;
+
+    static const size_t capacity = 8;
+
+    /// a request, with everything needed to send it again
+    struct Request {
+        uint32_t sequenceNumber = 0;
+        TuyaBLEFunctionCode code = TuyaBLEFunctionCode::senderDeviceInfo;
+        uint32_t responseTo = 0;
+
+        /// the data of the message, only kept when it might be retried
+        Buffer data;
+        uint8_t remainingRetries = 0;
+        unsigned long timeoutMs = 0;
+        ResponseHandler handler;
+        SentHandler onSent;
+
+        /// the callbacks of the datapoint writes this request carries, for its handler to call
+        std::vector<TuyaBLEStatusCallback> statusCallbacks;
+    };
+
+private:
+    struct Entry {
+        bool isInUse = false;
+        bool hasExpired = false;
+        Request request;
+    };
+
+    Entry _entries[capacity];
+    size_t _numberOfEntries = 0;
+    TuyaBLETimerWheel<capacity> _deadlines;
+    SemaphoreHandle_t _mutex = nullptr;
+
+    TuyaBLERequestTable(const TuyaBLERequestTable&) = delete;
+    TuyaBLERequestTable& operator=(const TuyaBLERequestTable&) = delete;
+
+    void lock() { xSemaphoreTake(_mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(_mutex); }
+
+    Entry* find(uint32_t sequenceNumber);
+    void removeEntry(Entry& entry);
+
+public:
+    TuyaBLERequestTable() { _mutex = xSemaphoreCreateMutex(); }
+    ~TuyaBLERequestTable() { vSemaphoreDelete(_mutex); }
+
+    /// adds a request that expects a response within its `timeoutMs` from `now`, or without a handler, one that only waits
+    /// for its message to be sent. The request is moved into the table, unless the table is full, in which case this returns false.
+    bool add(Request& request, unsigned long now);
+
+    /// if `response` responds to a request in the table, removes the request and calls its handler
+    bool complete(const TuyaBLEReceivedMessage& response, uint32_t responseToSequenceNumber);
+
+    /// once the message of a request went out or couldn't be sent, moves its `onSent` handler into `onSent`.
+    /// A request without a handler was only waiting for that and is removed. Returns false if there's no `onSent` handler
+    bool takeSentHandler(uint32_t sequenceNumber, SentHandler& onSent);
+    bool hasSentHandler(uint32_t sequenceNumber);
+
+    /// removes a request and calls its handler with `status`
+    bool fail(uint32_t sequenceNumber, TuyaBLERequestStatus status);
+
+    /// removes all requests and calls their handlers with `status`
+    void failAll(TuyaBLERequestStatus status);
+
+    /// advances the deadlines to `now` and moves one request whose deadline has passed into `expired`,
+    /// returns false when there are none left
+    bool takeExpired(unsigned long now, Request& expired);
+
+    bool contains(uint32_t sequenceNumber);
+    size_t size() const { return _numberOfEntries; }
+    bool isEmpty() const { return _numberOfEntries == 0; }
+    bool isFull() const { return _numberOfEntries == capacity; }
+};
+
+#endif//TUYA_BLE_REQUEST_TABLE_123
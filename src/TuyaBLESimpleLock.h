@@ -2,24 +2,39 @@
 #define TUYA_BLE_SIMPLE_LOCK_123
 
 #include "TuyaBLEDevice.h"
+#include "TuyaDataPointSchema.h"
 
 class TuyaBLESimpleLock: public TuyaBLEDevice {
 public:
-    static const uint8_t dpShortRangeUnlock = 6; // [send] raw
-    static const uint8_t dpBatteryLevel = 9; // [receive] enum, 0 = high, 1 = medium, 2 = low, 3 = exhausted
-    static const uint8_t dpUnlockStatus = 47; // [receive] bool, true = unlocked, false = locked
+    typedef TuyaDP<6, TuyaDPRaw, TuyaDPDirection::send> ShortRangeUnlock;
+    typedef TuyaDP<9, uint8_t, TuyaDPDirection::receive> BatteryLevel; // 0 = high, 1 = medium, 2 = low, 3 = exhausted
+    typedef TuyaDP<47, bool, TuyaDPDirection::receive> UnlockStatus; // true = unlocked, false = locked
+    typedef TuyaDPSchema<ShortRangeUnlock, BatteryLevel, UnlockStatus> Schema;
+
+    static const uint8_t dpShortRangeUnlock = ShortRangeUnlock::id;
+    static const uint8_t dpBatteryLevel = BatteryLevel::id;
+    static const uint8_t dpUnlockStatus = UnlockStatus::id;
 
     using TuyaBLEDevice::TuyaBLEDevice;
 
-    bool isLocked() const { return reportedBooleanDataPoint(dpUnlockStatus, false); }
+    const Schema& schema() const { return _schema; }
+
+    bool isLocked() const { return !_schema.get<UnlockStatus>(true); }
+    uint8_t batteryLevel() const { return _schema.get<BatteryLevel>(0); }
 
     void shortRangeUnlock(uint8_t memberId = 1, std::function<void(TuyaBLEDevice*)> callback = nullptr) {
-        sendDataPoint(TuyaDataPoint::raw(dpShortRangeUnlock, {1, memberId}), callback);
+        sendDataPoint(Schema::make<ShortRangeUnlock>(Buffer{1, memberId}), callback);
     }
 
     void shortRangeLock(uint8_t memberId = 1, std::function<void(TuyaBLEDevice*)> callback = nullptr) {
-        sendDataPoint(TuyaDataPoint::raw(dpShortRangeUnlock, {0, memberId}), callback);
+        sendDataPoint(Schema::make<ShortRangeUnlock>(Buffer{0, memberId}), callback);
     }
+
+protected:
+    TuyaDPDecodeResult decodeReportedDataPoint(const TuyaDataPoint& dataPoint) override { return _schema.decode(dataPoint); }
+
+private:
+    Schema _schema;
 };
 
-#endif//TUYA_BLE_SIMPLE_LOCK_123
\ No newline at end of file
+#endif//TUYA_BLE_SIMPLE_LOCK_123
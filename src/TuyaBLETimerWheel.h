@@ -0,0 +1,124 @@
+#ifndef TUYA_BLE_TIMER_WHEEL_123
+#define TUYA_BLE_TIMER_WHEEL_123
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/// A hashed timer wheel for a fixed number of timers, identified by their index (0..<Capacity).
+///
+/// Time is divided in ticks of `ResolutionMs`, and a timer goes in the slot of the tick it expires in,
+/// modulo the number of slots. Scheduling is O(1), advancing the wheel only looks at the slots of the ticks
+/// that passed, and nothing is allocated. Timers fire up to one tick late, never early.
+///
+/// Ticks are counted from when the wheel started, not derived from `millis()`: the wheel steps by the time that
+/// passed since the last step, so it keeps going when `millis()` wraps around (after about 49.7 days on the ESP32).
+template<size_t Capacity, size_t NumberOfSlots = 32, unsigned long ResolutionMs = 50>
+class TuyaBLETimerWheel {
+private:
+    static const uint8_t none = 0xFF;
+    static_assert(Capacity < none, "timers are identified by a uint8_t");
+
+    uint8_t _slotHeads[NumberOfSlots];
+    uint8_t _next[Capacity];
+    uint32_t _expiryTicks[Capacity];
+    bool _isScheduled[Capacity];
+    size_t _numberOfScheduledTimers = 0;
+
+    /// the tick the wheel is at, and the `millis()` time that tick started at
+    uint32_t _currentTick = 0;
+    unsigned long _currentTickMs = 0;
+    bool _hasStarted = false;
+
+    /// milliseconds from the start of the current tick to `timeMs`, negative if that's before it
+    long millisecondsSinceCurrentTick(unsigned long timeMs) const { return static_cast<long>(timeMs - _currentTickMs); }
+
+    void unlink(uint8_t timer) {
+        uint8_t* link = &_slotHeads[_expiryTicks[timer] % NumberOfSlots];
+        while(*link != none && *link != timer) link = &_next[*link];
+        if(*link == timer) *link = _next[timer];
+    }
+
+public:
+    TuyaBLETimerWheel() { clear(); }
+
+    /// cancels all timers
+    void clear() {
+        for(size_t slot = 0; slot < NumberOfSlots; slot++) _slotHeads[slot] = none;
+        for(size_t timer = 0; timer < Capacity; timer++) _isScheduled[timer] = false;
+        _numberOfScheduledTimers = 0;
+    }
+
+    /// (re)schedules `timer` to fire at `deadlineMs`, both in `millis()` time
+    void schedule(size_t timer, unsigned long nowMs, unsigned long deadlineMs) {
+        cancel(timer);
+
+        // without timers the wheel may not have been advanced in a long time, so it starts over at `nowMs`
+        if(!_hasStarted || _numberOfScheduledTimers == 0) {
+            _currentTickMs = nowMs;
+            _hasStarted = true;
+        }
+
+        // the deadline as a number of ticks from the current one. Deadlines that already passed fire on
+        // the next tick, rounding up means we never fire early
+        long delayMs = millisecondsSinceCurrentTick(nowMs) + static_cast<long>(deadlineMs - nowMs);
+        uint32_t numberOfTicks = delayMs > 0 ? static_cast<uint32_t>((static_cast<unsigned long>(delayMs) + ResolutionMs - 1) / ResolutionMs) : 1;
+        uint32_t expiryTick = _currentTick + numberOfTicks;
+
+        uint8_t slot = expiryTick % NumberOfSlots;
+        _expiryTicks[timer] = expiryTick;
+        _next[timer] = _slotHeads[slot];
+        _slotHeads[slot] = static_cast<uint8_t>(timer);
+        _isScheduled[timer] = true;
+        _numberOfScheduledTimers += 1;
+    }
+
+    void cancel(size_t timer) {
+        if(!_isScheduled[timer]) return;
+        unlink(static_cast<uint8_t>(timer));
+        _isScheduled[timer] = false;
+        _numberOfScheduledTimers -= 1;
+    }
+
+    bool isScheduled(size_t timer) const { return _isScheduled[timer]; }
+
+    /// moves the wheel forward to `nowMs` and calls `onExpired(timer)` for every timer that expired.
+    /// Expired timers are unscheduled before `onExpired` is called, so it may schedule them again.
+    template<typename Function> void advance(unsigned long nowMs, Function onExpired) {
+        if(!_hasStarted || _numberOfScheduledTimers == 0) {
+            _currentTickMs = nowMs;
+            _hasStarted = true;
+            return;
+        }
+
+        // whole ticks only, the rest of the elapsed time counts towards the next advance.
+        // A `nowMs` from just before the current tick (read on another task) moves nothing
+        long elapsedMs = millisecondsSinceCurrentTick(nowMs);
+        if(elapsedMs < static_cast<long>(ResolutionMs)) return;
+        uint32_t numberOfTicks = static_cast<uint32_t>(static_cast<unsigned long>(elapsedMs) / ResolutionMs);
+        _currentTickMs += static_cast<unsigned long>(numberOfTicks) * ResolutionMs;
+
+        // the wheel is at the target before any timer fires, so timers scheduled from `onExpired` are relative to it.
+        // After a long pause, each slot only needs to be looked at once
+        uint32_t targetTick = _currentTick + numberOfTicks;
+        uint32_t tick = numberOfTicks > NumberOfSlots ? targetTick - NumberOfSlots : _currentTick;
+        _currentTick = targetTick;
+
+        while(tick != targetTick) {
+            tick += 1;
+            uint8_t* link = &_slotHeads[tick % NumberOfSlots];
+            while(*link != none) {
+                uint8_t timer = *link;
+                if(static_cast<int32_t>(_expiryTicks[timer] - targetTick) <= 0) {
+                    *link = _next[timer];
+                    _isScheduled[timer] = false;
+                    _numberOfScheduledTimers -= 1;
+                    onExpired(static_cast<size_t>(timer));
+                } else {
+                    link = &_next[timer];
+                }
+            }
+        }
+    }
+};
+
+#endif//TUYA_BLE_TIMER_WHEEL_123
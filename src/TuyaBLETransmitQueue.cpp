@@ -0,0 +1,223 @@
+#include "TuyaBLETransmitQueue.h"
+
+#include <algorithm>
+
+TuyaBLETransmitQueue::TuyaBLETransmitQueue() {
+    _mutex = xSemaphoreCreateMutex();
+    _taskStopped = xSemaphoreCreateBinary();
+}
+
+TuyaBLETransmitQueue::~TuyaBLETransmitQueue() {
+    stop();
+    if(_isTaskExiting) xSemaphoreTake(_taskStopped, portMAX_DELAY);
+
+    vSemaphoreDelete(_taskStopped);
+    vSemaphoreDelete(_mutex);
+}
+
+// MARK: - Starting and stopping
+void TuyaBLETransmitQueue::start(WriteFunction write, CompletionFunction completion) {
+    stop();
+
+    // a task that stopped itself from a completion function might still be on its way out
+    if(_isTaskExiting) {
+        xSemaphoreTake(_taskStopped, portMAX_DELAY);
+        _isTaskExiting = false;
+    }
+
+    _write = write;
+    _completion = completion;
+
+    lock();
+    size_t numberOfEntries = std::max(size_t(1), _configuration.maximumNumberOfQueuedMessages);
+    if(_entries.size() != numberOfEntries) {
+        _entries.clear();
+        _entries.resize(numberOfEntries);
+    }
+    _head = 0;
+    _numberOfQueuedMessages = 0;
+    _numberOfQueuedPackets = 0;
+    unlock();
+
+    _credits = std::max(uint32_t(1), _configuration.maximumNumberOfCredits);
+    _lastCreditTime = millis();
+    _isRunning = true;
+
+    if(xTaskCreate(&TuyaBLETransmitQueue::taskMain, "TuyaBLETx", _configuration.taskStackSize, this, _configuration.taskPriority, &_task) != pdPASS) {
+        _task = nullptr;
+    }
+}
+
+void TuyaBLETransmitQueue::stop() {
+    if(!_isRunning) return;
+    _isRunning = false;
+
+    if(_task != nullptr) {
+        if(xTaskGetCurrentTaskHandle() == _task) {
+            // we're in a completion function: the task exits when it returns
+            _isTaskExiting = true;
+        } else {
+            xTaskNotifyGive(_task);
+            xSemaphoreTake(_taskStopped, portMAX_DELAY);
+        }
+        _task = nullptr;
+    }
+
+    failQueuedMessages();
+}
+
+void TuyaBLETransmitQueue::failQueuedMessages() {
+    while(true) {
+        lock();
+        if(_numberOfQueuedMessages == 0) {
+            unlock();
+            return;
+        }
+
+        Entry& entry = _entries[_head];
+        uint32_t tag = entry.tag;
+        _numberOfQueuedPackets -= entry.frame.numberOfPackets();
+        entry.frame.clear();
+        _head = (_head + 1) % _entries.size();
+        _numberOfQueuedMessages -= 1;
+        unlock();
+
+        if(_completion)
+            _completion(tag, false);
+    }
+}
+
+// MARK: - Queueing
+TuyaBLEEncodedFrame* TuyaBLETransmitQueue::beginEnqueue() {
+    if(!_isRunning) return nullptr;
+
+    lock();
+    if(_numberOfQueuedMessages == _entries.size()) {
+        unlock();
+        return nullptr;
+    }
+
+    // the free entry isn't touched by the sender task, we keep the lock until `endEnqueue()` so other callers don't take it too
+    Entry& entry = _entries[(_head + _numberOfQueuedMessages) % _entries.size()];
+    entry.frame.clear();
+    return &entry.frame;
+}
+
+bool TuyaBLETransmitQueue::endEnqueue(uint32_t tag) {
+    Entry& entry = _entries[(_head + _numberOfQueuedMessages) % _entries.size()];
+    size_t numberOfPackets = entry.frame.numberOfPackets();
+    bool hasRoom = numberOfPackets > 0
+        && (_numberOfQueuedMessages == 0 || _numberOfQueuedPackets + numberOfPackets <= _configuration.maximumNumberOfQueuedPackets);
+    if(!hasRoom) {
+        entry.frame.clear();
+        unlock();
+        return false;
+    }
+
+    entry.tag = tag;
+    _numberOfQueuedMessages += 1;
+    _numberOfQueuedPackets += numberOfPackets;
+    unlock();
+
+    if(_task != nullptr) {
+        xTaskNotifyGive(_task);
+    } else {
+        drain();
+    }
+    return true;
+}
+
+// MARK: - Sending
+void TuyaBLETransmitQueue::taskMain(void* parameter) {
+    TuyaBLETransmitQueue* queue = static_cast<TuyaBLETransmitQueue*>(parameter);
+    queue->run();
+
+    xSemaphoreGive(queue->_taskStopped);
+    vTaskDelete(nullptr);
+}
+
+void TuyaBLETransmitQueue::run() {
+    while(_isRunning) {
+        ulTaskNotifyTake(pdTRUE, _tick ? pdMS_TO_TICKS(_tickIntervalMs) : portMAX_DELAY);
+        if(!_isRunning) break;
+        drain();
+
+        if(_tick && _isRunning)
+            _tick();
+    }
+}
+
+void TuyaBLETransmitQueue::drain() {
+    while(_isRunning) {
+        lock();
+        if(_numberOfQueuedMessages == 0) {
+            unlock();
+            return;
+        }
+        Entry& entry = _entries[_head];
+        unlock();
+
+        bool success = transmit(entry);
+
+        lock();
+        uint32_t tag = entry.tag;
+        _numberOfQueuedPackets -= entry.frame.numberOfPackets();
+        entry.frame.clear();
+        _head = (_head + 1) % _entries.size();
+        _numberOfQueuedMessages -= 1;
+        unlock();
+
+        if(_completion)
+            _completion(tag, success);
+    }
+}
+
+bool TuyaBLETransmitQueue::transmit(const Entry& entry) {
+    for(size_t index = 0; index < entry.frame.numberOfPackets(); index++) {
+        BufferView packet = entry.frame.packet(index);
+        if(!writePacket(packet.data(), packet.size())) return false;
+    }
+    return true;
+}
+
+bool TuyaBLETransmitQueue::writePacket(const uint8_t* data, size_t length) {
+    for(uint32_t attempt = 0; ; attempt++) {
+        waitForCredit();
+        if(!_isRunning) return false;
+
+        if(_write(data, length)) {
+            _credits -= 1;
+            return true;
+        }
+
+        // the stack's buffers are full, give them time to drain before trying again
+        _credits = 0;
+        _lastCreditTime = millis();
+        if(attempt >= _configuration.maximumNumberOfWriteRetries) return false;
+        delay(_configuration.retryBackoffMs << attempt);
+    }
+}
+
+void TuyaBLETransmitQueue::waitForCredit() {
+    const uint32_t maximumNumberOfCredits = std::max(uint32_t(1), _configuration.maximumNumberOfCredits);
+    const uint32_t creditIntervalMs = _configuration.creditIntervalMs;
+
+    while(_isRunning) {
+        unsigned long now = millis();
+        if(creditIntervalMs == 0) {
+            _credits = maximumNumberOfCredits;
+        } else {
+            uint32_t earnedCredits = static_cast<uint32_t>((now - _lastCreditTime) / creditIntervalMs);
+            if(earnedCredits >= maximumNumberOfCredits - _credits) {
+                _credits = maximumNumberOfCredits;
+                _lastCreditTime = now;
+            } else if(earnedCredits > 0) {
+                _credits += earnedCredits;
+                _lastCreditTime += earnedCredits * creditIntervalMs;
+            }
+        }
+
+        if(_credits > 0) return;
+        delay(creditIntervalMs);
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef TUYA_BLE_TRANSMIT_QUEUE_123
+#define TUYA_BLE_TRANSMIT_QUEUE_123
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include <functional>
+#include <vector>
+
+#include "TuyaBLEFrameEncoder.h"
+
+/// Sends the packets of outbound messages from a task of its own, so the caller of
+/// `enqueue()` doesn't wait while a multi-packet message goes out.
+///
+/// Packets are written without response. To keep the BLE stack's transmit buffers busy without overflowing
+/// them, writes are paced with credits: each write takes a credit and credits come back over time, up to
+/// `maximumNumberOfCredits`. A write the stack refuses (its buffers are full) drains the credits and is retried
+/// with an exponential backoff. A message that can't be written within `maximumNumberOfWriteRetries` fails.
+///
+/// Each message has a tag, such as its sequence number. The completion function given to `start()` is called on the
+/// sender task with the tag and `true` when all its packets have been handed to the stack, or `false` when writing
+/// failed or the queue was stopped first. Nothing is allocated per message: `enqueue()` takes its encoder as a
+/// template argument and the entries only keep the tag.
+class TuyaBLETransmitQueue {
+public:
+    typedef std::function<bool(const uint8_t* data, size_t length)> WriteFunction;
+    typedef std::function<void(uint32_t tag, bool success)> CompletionFunction;
+    typedef std::function<void()> TickFunction;
+
+    struct Configuration {
+        /// the queue is bounded by both the number of messages and the number of packets in them,
+        /// a single message is always accepted by an empty queue
+        size_t maximumNumberOfQueuedMessages = 8;
+        size_t maximumNumberOfQueuedPackets = 64;
+
+        /// pacing of writes without response
+        uint32_t maximumNumberOfCredits = 4;
+        uint32_t creditIntervalMs = 8;
+
+        /// retrying writes the stack refused, the n-th retry waits `retryBackoffMs << n`
+        uint32_t maximumNumberOfWriteRetries = 5;
+        uint32_t retryBackoffMs = 4;
+
+        /// the sender task
+        uint32_t taskStackSize = 4096;
+        UBaseType_t taskPriority = 1;
+    };
+
+private:
+    /// a queued message. The entries are reused, so once the queue has been
+    /// warmed up, messages are encoded into them without allocating.
+    struct Entry {
+        TuyaBLEEncodedFrame frame;
+        uint32_t tag = 0;
+    };
+
+    Configuration _configuration;
+    WriteFunction _write;
+    CompletionFunction _completion;
+    TickFunction _tick;
+    volatile uint32_t _tickIntervalMs = 0;
+
+    /// ring of entries, guarded by `_mutex`. Messages are encoded into a free entry while holding the lock,
+    /// the sender task writes the entry at `_head` without it, since nobody else touches that entry.
+    std::vector<Entry> _entries;
+    size_t _head = 0;
+    size_t _numberOfQueuedMessages = 0;
+    size_t _numberOfQueuedPackets = 0;
+    SemaphoreHandle_t _mutex = nullptr;
+
+    /// the sender task, given `_taskStopped` when it exits
+    TaskHandle_t _task = nullptr;
+    SemaphoreHandle_t _taskStopped = nullptr;
+    bool _isTaskExiting = false;
+    volatile bool _isRunning = false;
+
+    /// credits, only used by whoever is draining the queue
+    uint32_t _credits = 0;
+    unsigned long _lastCreditTime = 0;
+
+    TuyaBLETransmitQueue(const TuyaBLETransmitQueue&) = delete;
+    TuyaBLETransmitQueue& operator=(const TuyaBLETransmitQueue&) = delete;
+
+    void lock() { xSemaphoreTake(_mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGive(_mutex); }
+
+    TuyaBLEEncodedFrame* beginEnqueue();
+    bool endEnqueue(uint32_t tag);
+
+    static void taskMain(void* parameter);
+    void run();
+    void drain();
+    bool transmit(const Entry& entry);
+    bool writePacket(const uint8_t* data, size_t length);
+    void waitForCredit();
+    void failQueuedMessages();
+
+public:
+    TuyaBLETransmitQueue();
+    ~TuyaBLETransmitQueue();
+
+    /// only applied by the next `start()`
+    void setConfiguration(const Configuration& configuration) { _configuration = configuration; }
+    const Configuration& configuration() const { return _configuration; }
+
+    /// starts the sender task, packets are written with `write` and `completion` is called for every message
+    /// that went out or failed. If the task can't be created, messages are written on the caller's task instead.
+    void start(WriteFunction write, CompletionFunction completion);
+
+    /// `tick` is called on the sender task at least every `intervalMs` while it runs, in between
+    /// messages, e.g. to service timers without needing a task of its own
+    void setTickFunction(TickFunction tick, uint32_t intervalMs) {
+        _tick = tick;
+        _tickIntervalMs = intervalMs;
+    }
+    /// can be changed while the task runs, it's used from the next wait on
+    void setTickInterval(uint32_t intervalMs) { _tickIntervalMs = intervalMs; }
+
+    /// stops the sender task and fails all queued messages. Waits for a packet that's
+    /// being written, unless called from a completion function.
+    void stop();
+    bool isRunning() const { return _isRunning; }
+    /// false when messages are written on the caller's task, in which case the tick function isn't called
+    bool hasSenderTask() const { return _task != nullptr; }
+
+    /// queues a message tagged `tag`, which `encode(TuyaBLEEncodedFrame&)` encodes straight into the queue's storage.
+    /// Returns false (without calling the completion function) if the queue isn't running, is full or `encode` produced no packets
+    template<typename Encoder> bool enqueue(const Encoder& encode, uint32_t tag) {
+        TuyaBLEEncodedFrame* frame = beginEnqueue();
+        if(frame == nullptr) return false;
+        encode(*frame);
+        return endEnqueue(tag);
+    }
+
+    size_t numberOfQueuedMessages() const { return _numberOfQueuedMessages; }
+};
+
+#endif//TUYA_BLE_TRANSMIT_QUEUE_123
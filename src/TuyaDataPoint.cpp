@@ -1,7 +1,108 @@
 #include "TuyaDataPoint.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 const TuyaDataPoint TuyaDataPoint::invalid = TuyaDataPoint();
 
+// MARK: - Storage
+void TuyaDataPoint::setPayload(TuyaDataPointType type, const void* data, size_t size) {
+    if(size > maximumPayloadSize) size = maximumPayloadSize;
+
+    // the new payload is stored before the old one is released, `data` might point into it
+    uint8_t* heapPayload = nullptr;
+    if(size > inlinePayloadCapacity) {
+        heapPayload = static_cast<uint8_t*>(malloc(size));
+        if(heapPayload == nullptr) size = 0;
+        else memcpy(heapPayload, data, size);
+    }
+
+    uint8_t inlinePayload[inlinePayloadCapacity];
+    if(heapPayload == nullptr && size > 0) memcpy(inlinePayload, data, size);
+
+    releasePayload();
+    _type = type;
+    _payloadSize = static_cast<uint16_t>(size);
+    if(heapPayload != nullptr) {
+        _heapPayload = heapPayload;
+    } else {
+        memcpy(_inlinePayload, inlinePayload, size);
+    }
+}
+
+void TuyaDataPoint::setScalar(TuyaDataPointType type, int32_t value) {
+    releasePayload();
+    _type = type;
+    _value = value;
+}
+
+void TuyaDataPoint::releasePayload() {
+    if(isPayloadOnHeap()) free(_heapPayload);
+    _payloadSize = 0;
+    _value = 0;
+}
+
+void TuyaDataPoint::copyFrom(const TuyaDataPoint& other) {
+    _dp = other._dp;
+    _type = other._type;
+    _payloadSize = 0;
+    _value = 0;
+
+    if(other.isPayloadOnHeap()) {
+        setPayload(other._type, other._heapPayload, other._payloadSize);
+    } else {
+        _payloadSize = other._payloadSize;
+        memcpy(_inlinePayload, other._inlinePayload, inlinePayloadCapacity);
+    }
+}
+
+void TuyaDataPoint::moveFrom(TuyaDataPoint& other) {
+    // the heap payload, if any, changes owner
+    _dp = other._dp;
+    _type = other._type;
+    _payloadSize = other._payloadSize;
+    memcpy(_inlinePayload, other._inlinePayload, inlinePayloadCapacity);
+
+    other._payloadSize = 0;
+    other._value = 0;
+}
+
+// MARK: - Encoding
+void TuyaDataPoint::encode(Buffer& output, size_t numberOfLengthBytes) const {
+    output.append(_dp);
+    output.append(static_cast<uint8_t>(_type));
+
+    switch(_type) {
+        case TuyaDataPointType::raw:
+        case TuyaDataPointType::string:
+        case TuyaDataPointType::bitmap:
+            output.appendBigEndianWithNumberOfBytes(_payloadSize, numberOfLengthBytes);
+            output.append(payloadBytes(), _payloadSize);
+        break;
+
+        case TuyaDataPointType::boolean:
+            output.appendBigEndianWithNumberOfBytes(1, numberOfLengthBytes);
+            output.append(static_cast<uint8_t>(boolean() ? 1 : 0));
+        break;
+
+        case TuyaDataPointType::value:
+        case TuyaDataPointType::enumeration:
+            // both go out as a 4 byte big endian integer
+            output.appendBigEndianWithNumberOfBytes(4, numberOfLengthBytes);
+            output.appendBigEndian(static_cast<int32_t>(_value));
+        break;
+    }
+}
+
+// MARK: - Comparing
+bool TuyaDataPoint::operator==(const TuyaDataPoint& other) const {
+    if(_dp != other._dp || _type != other._type) return false;
+    if(!hasPayload(_type)) return _value == other._value;
+    return _payloadSize == other._payloadSize && memcmp(payloadBytes(), other.payloadBytes(), _payloadSize) == 0;
+}
+
+// MARK: - Debugging
+
 String TuyaDataPoint::debugDescription() const {
     String output = "dp = " + String(dp()) + ", type = ";
 
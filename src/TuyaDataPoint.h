@@ -2,6 +2,7 @@
 #define TUYA_DATAPOINT_123
 
 #include "Buffer.h"
+#include "BufferView.h"
 
 enum class TuyaDataPointType: uint8_t {
     raw = 0,
@@ -14,24 +15,71 @@ enum class TuyaDataPointType: uint8_t {
 
 class String;
 
+/// A single datapoint: its id, its type and a value of that type.
+///
+/// Datapoints are kept around in large numbers, so they're stored compactly: booleans, values and
+/// enumerations inline, raw, string and bitmap payloads inline up to `inlinePayloadCapacity`
+/// bytes and on the heap beyond that. Payloads are limited to 65535 bytes, the most a message can carry.
 class TuyaDataPoint {
+public:
+    static const size_t inlinePayloadCapacity = 12;
+    static const size_t maximumPayloadSize = 0xFFFF;
+
 private:
     uint8_t _dp = 0;
     TuyaDataPointType _type = TuyaDataPointType::raw;
+    uint16_t _payloadSize = 0;
+    union {
+        int32_t _value;
+        uint8_t _inlinePayload[inlinePayloadCapacity];
+        uint8_t* _heapPayload;
+    };
 
-    Buffer _buffer;
-    int32_t _value = 0;
-    uint8_t _enumeration = 0;
-    String _string;
+    TuyaDataPoint() : _value(0) {}
 
-    TuyaDataPoint() {}
+    static bool hasPayload(TuyaDataPointType type) {
+        return type == TuyaDataPointType::raw || type == TuyaDataPointType::string || type == TuyaDataPointType::bitmap;
+    }
+    bool isPayloadOnHeap() const { return hasPayload(_type) && _payloadSize > inlinePayloadCapacity; }
+    const uint8_t* payloadBytes() const { return isPayloadOnHeap() ? _heapPayload : _inlinePayload; }
+
+    void setPayload(TuyaDataPointType type, const void* data, size_t size);
+    void setScalar(TuyaDataPointType type, int32_t value);
+    void releasePayload();
+    void copyFrom(const TuyaDataPoint& other);
+    void moveFrom(TuyaDataPoint& other);
 
 public:
-    TuyaDataPoint(uint8_t dp, TuyaDataPointType type): _dp(dp), _type(type) {}
+    TuyaDataPoint(uint8_t dp, TuyaDataPointType type): _dp(dp), _type(type), _value(0) {}
+
+    TuyaDataPoint(const TuyaDataPoint& other) { copyFrom(other); }
+    TuyaDataPoint(TuyaDataPoint&& other) { moveFrom(other); }
+
+    TuyaDataPoint& operator=(const TuyaDataPoint& other) {
+        if(this != &other) {
+            releasePayload();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    TuyaDataPoint& operator=(TuyaDataPoint&& other) {
+        if(this != &other) {
+            releasePayload();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    ~TuyaDataPoint() { releasePayload(); }
 
     static const TuyaDataPoint invalid;
 
     static TuyaDataPoint raw(uint8_t dp, const Buffer& value) {
+        return raw(dp, value.view());
+    }
+
+    static TuyaDataPoint raw(uint8_t dp, const BufferView& value) {
         TuyaDataPoint dataPoint(dp, TuyaDataPointType::raw);
         dataPoint.setRaw(value);
         return dataPoint;
@@ -62,6 +110,10 @@ public:
     }
 
     static TuyaDataPoint bitmap(uint8_t dp, const Buffer& value) {
+        return bitmap(dp, value.view());
+    }
+
+    static TuyaDataPoint bitmap(uint8_t dp, const BufferView& value) {
         TuyaDataPoint dataPoint(dp, TuyaDataPointType::bitmap);
         dataPoint.setBitmap(value);
         return dataPoint;
@@ -70,44 +122,55 @@ public:
     TuyaDataPointType type() const { return _type; }
     bool isValid() const { return _dp != 0; }
 
-    const Buffer& raw() const { return _buffer; }
-    bool boolean() const  { return _value != 0; }
-    int32_t value() const  { return _value; }
-    const String& string() const  { return _string; }
-    uint8_t enumeration() const  { return static_cast<uint8_t>(_value); }
-    const Buffer& bitmap() const { return _buffer; }
+    /// the bytes of a raw, string or bitmap datapoint, only valid as long as this datapoint isn't changed
+    BufferView payload() const { return hasPayload(_type) ? BufferView(payloadBytes(), _payloadSize) : BufferView(); }
+
+    BufferView raw() const { return payload(); }
+    bool boolean() const  { return !hasPayload(_type) && _value != 0; }
+    int32_t value() const  { return hasPayload(_type) ? 0 : _value; }
+    String string() const  { return payload().asString(); }
+    uint8_t enumeration() const  { return static_cast<uint8_t>(value()); }
+    BufferView bitmap() const { return payload(); }
 
-    void setRaw(const Buffer& data) { 
-        _buffer = data; 
-        _string = "";
-        _value = 0;
+    void setRaw(const BufferView& data) {
+        setPayload(TuyaDataPointType::raw, data.data(), data.size());
     }
 
+    // booleans are stored inverted, as they always have been: `boolean(dp, true)` sends 0 and a reported 1
+    // reads as false. Sketches depend on what this puts on the wire, so it stays until a major version
     void setBoolean(bool value) {
-        setValue(value ? 0 : 1);
+        setScalar(TuyaDataPointType::boolean, value ? 0 : 1);
     }
 
     void setValue(int32_t value) {
-        _value = value;
-        _buffer = Buffer();
-        _string = "";
+        setScalar(TuyaDataPointType::value, value);
     }
 
     void setString(const String& string) {
-        _string = string;
-        _buffer = Buffer();
-        _value = 0;
+        setPayload(TuyaDataPointType::string, string.c_str(), string.length());
+    }
+
+    void setString(const BufferView& string) {
+        setPayload(TuyaDataPointType::string, string.data(), string.size());
     }
 
     void setEnumeration(int32_t enumeration) {
-        setValue(enumeration);
+        setScalar(TuyaDataPointType::enumeration, enumeration);
     }
 
-    void setBitmap(const Buffer& bitmap) {
-        setRaw(bitmap);
+    void setBitmap(const BufferView& bitmap) {
+        setPayload(TuyaDataPointType::bitmap, bitmap.data(), bitmap.size());
     }
 
+    /// appends this datapoint as it is sent: id, type, the length of the value in `numberOfLengthBytes`
+    /// bytes (1, or 2 for the v4 messages) and the value
+    void encode(Buffer& output, size_t numberOfLengthBytes) const;
+
+    /// datapoints are equal if they have the same id, type and value
+    bool operator==(const TuyaDataPoint& other) const;
+    bool operator!=(const TuyaDataPoint& other) const { return !(*this == other); }
+
     String debugDescription() const;
 };
 
-#endif//TUYA_DATAPOINT_123
\ No newline at end of file
+#endif//TUYA_DATAPOINT_123
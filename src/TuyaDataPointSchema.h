@@ -0,0 +1,244 @@
+#ifndef TUYA_DATAPOINT_SCHEMA_123
+#define TUYA_DATAPOINT_SCHEMA_123
+
+#include <Arduino.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <bitset>
+#include <tuple>
+#include <type_traits>
+
+#include "Buffer.h"
+#include "BufferView.h"
+#include "TuyaDataPoint.h"
+
+/// Declares the datapoints of a device profile, with their ids, types and directions, at compile time:
+///
+///     typedef TuyaDP<47, bool, TuyaDPDirection::receive> UnlockStatus;
+///     typedef TuyaDP<71, TuyaDPRaw, TuyaDPDirection::send> LockUnlock;
+///     typedef TuyaDPSchema<UnlockStatus, LockUnlock> Schema;
+///
+///     Schema schema;
+///     schema.decode(receivedDataPoint);                  // only decodes known datapoints
+///     bool isUnlocked = schema.get<UnlockStatus>(false); // typed, from typed storage
+///     TuyaDataPoint dp = Schema::make<LockUnlock>(data); // typed, ready to send
+///
+/// A schema object keeps the last decoded value of each received datapoint in fixed typed storage. Device profiles
+/// decode reported datapoints into their schema in place of the device's generic `TuyaDataPointStore`, so each
+/// datapoint is kept once. Reading a datapoint that isn't received, sending one that isn't sent, passing a value of
+/// the wrong type or using a datapoint that isn't part of the schema doesn't compile.
+
+/// in which direction a datapoint goes
+enum class TuyaDPDirection: uint8_t {
+    send = 1,
+    receive = 2,
+    sendAndReceive = 3,
+};
+
+/// what `TuyaDPSchema::decode()` did with a datapoint
+enum class TuyaDPDecodeResult: uint8_t {
+    notInSchema = 0, // not received according to the schema, or of another type than declared: nothing is stored
+    unchanged = 1,
+    changed = 2,
+};
+
+/// value types of raw and bitmap datapoints, both are bytes
+struct TuyaDPRaw {};
+struct TuyaDPBitmap {};
+
+/// maps the value type of a datapoint to its `TuyaDataPointType`, its typed storage and how its value is stored, read
+/// and written. `store()` returns whether the stored value changed. Only declared for the supported types: bool,
+/// int32_t (value), uint8_t (enumeration), String, TuyaDPRaw and TuyaDPBitmap. Strings are copied out, raw and bitmap
+/// values are views on the storage they're read from
+template<typename T> struct TuyaDPValueTraits;
+
+template<typename T>
+bool TuyaDPStoreValue(const T& value, T& storage) {
+    if(storage == value) return false;
+    storage = value;
+    return true;
+}
+
+inline bool TuyaDPBytesAreEqual(const BufferView& value, const void* bytes, size_t length) {
+    return value.size() == length && (length == 0 || memcmp(value.data(), bytes, length) == 0);
+}
+
+// compared before copying, so decoding an unchanged payload doesn't allocate
+inline bool TuyaDPStoreBytes(const BufferView& value, Buffer& storage) {
+    if(TuyaDPBytesAreEqual(value, storage.data(), storage.size())) return false;
+    storage.clear();
+    storage.append(value);
+    return true;
+}
+
+// `TuyaDataPoint` stores booleans inverted for compatibility (see `setBoolean()`), a schema's bool is what's on the wire
+template<> struct TuyaDPValueTraits<bool> {
+    static constexpr TuyaDataPointType type = TuyaDataPointType::boolean;
+    typedef bool Value;
+    typedef bool Storage;
+    static bool store(const TuyaDataPoint& dataPoint, Storage& storage) { return TuyaDPStoreValue(!dataPoint.boolean(), storage); }
+    static Value load(const Storage& storage) { return storage; }
+    static TuyaDataPoint encode(uint8_t dp, Value value) { return TuyaDataPoint::boolean(dp, !value); }
+};
+
+template<> struct TuyaDPValueTraits<int32_t> {
+    static constexpr TuyaDataPointType type = TuyaDataPointType::value;
+    typedef int32_t Value;
+    typedef int32_t Storage;
+    static bool store(const TuyaDataPoint& dataPoint, Storage& storage) { return TuyaDPStoreValue(dataPoint.value(), storage); }
+    static Value load(const Storage& storage) { return storage; }
+    static TuyaDataPoint encode(uint8_t dp, Value value) { return TuyaDataPoint::value(dp, value); }
+};
+
+template<> struct TuyaDPValueTraits<uint8_t> {
+    static constexpr TuyaDataPointType type = TuyaDataPointType::enumeration;
+    typedef uint8_t Value;
+    typedef uint8_t Storage;
+    static bool store(const TuyaDataPoint& dataPoint, Storage& storage) { return TuyaDPStoreValue(dataPoint.enumeration(), storage); }
+    static Value load(const Storage& storage) { return storage; }
+    static TuyaDataPoint encode(uint8_t dp, Value value) { return TuyaDataPoint::enumeration(dp, value); }
+};
+
+template<> struct TuyaDPValueTraits<String> {
+    static constexpr TuyaDataPointType type = TuyaDataPointType::string;
+    typedef String Value;
+    typedef String Storage;
+    static bool store(const TuyaDataPoint& dataPoint, Storage& storage) {
+        if(TuyaDPBytesAreEqual(dataPoint.payload(), storage.c_str(), storage.length())) return false;
+        storage = dataPoint.string();
+        return true;
+    }
+    static Value load(const Storage& storage) { return storage; }
+    static TuyaDataPoint encode(uint8_t dp, Value value) { return TuyaDataPoint::string(dp, value); }
+};
+
+// raw and bitmap storage keeps its capacity, so decoding a payload of the same size again doesn't allocate
+template<> struct TuyaDPValueTraits<TuyaDPRaw> {
+    static constexpr TuyaDataPointType type = TuyaDataPointType::raw;
+    typedef BufferView Value;
+    typedef Buffer Storage;
+    static bool store(const TuyaDataPoint& dataPoint, Storage& storage) { return TuyaDPStoreBytes(dataPoint.raw(), storage); }
+    static Value load(const Storage& storage) { return storage.view(); }
+    static TuyaDataPoint encode(uint8_t dp, Value value) { return TuyaDataPoint::raw(dp, value); }
+};
+
+template<> struct TuyaDPValueTraits<TuyaDPBitmap> {
+    static constexpr TuyaDataPointType type = TuyaDataPointType::bitmap;
+    typedef BufferView Value;
+    typedef Buffer Storage;
+    static bool store(const TuyaDataPoint& dataPoint, Storage& storage) { return TuyaDPStoreBytes(dataPoint.bitmap(), storage); }
+    static Value load(const Storage& storage) { return storage.view(); }
+    static TuyaDataPoint encode(uint8_t dp, Value value) { return TuyaDataPoint::bitmap(dp, value); }
+};
+
+/// the storage of datapoints we only send, they don't have a value to keep
+struct TuyaDPNoStorage {};
+
+/// a single datapoint of a schema
+template<uint8_t Id, typename T, TuyaDPDirection Direction>
+struct TuyaDP {
+    typedef TuyaDPValueTraits<T> Traits;
+    typedef typename Traits::Value Value;
+
+    static constexpr uint8_t id = Id;
+    static constexpr TuyaDataPointType type = Traits::type;
+    static constexpr bool canSend = (static_cast<uint8_t>(Direction) & static_cast<uint8_t>(TuyaDPDirection::send)) != 0;
+    static constexpr bool canReceive = (static_cast<uint8_t>(Direction) & static_cast<uint8_t>(TuyaDPDirection::receive)) != 0;
+
+    typedef typename std::conditional<canReceive, typename Traits::Storage, TuyaDPNoStorage>::type Storage;
+
+    static_assert(Id != 0, "datapoint id 0 is reserved for invalid datapoints");
+};
+
+// MARK: - Compile time helpers
+template<uint8_t Id, uint8_t... Ids> struct TuyaDPIdIsNotIn : std::true_type {};
+template<uint8_t Id, uint8_t First, uint8_t... Rest> struct TuyaDPIdIsNotIn<Id, First, Rest...>
+    : std::integral_constant<bool, Id != First && TuyaDPIdIsNotIn<Id, Rest...>::value> {};
+
+template<uint8_t... Ids> struct TuyaDPIdsAreUnique : std::true_type {};
+template<uint8_t First, uint8_t... Rest> struct TuyaDPIdsAreUnique<First, Rest...>
+    : std::integral_constant<bool, TuyaDPIdIsNotIn<First, Rest...>::value && TuyaDPIdsAreUnique<Rest...>::value> {};
+
+/// the position of `DP` in `DPs`, or the number of `DPs` if it isn't one of them
+template<typename DP, typename... DPs> struct TuyaDPIndexOf : std::integral_constant<size_t, 0> {};
+template<typename DP, typename... Rest> struct TuyaDPIndexOf<DP, DP, Rest...> : std::integral_constant<size_t, 0> {};
+template<typename DP, typename First, typename... Rest> struct TuyaDPIndexOf<DP, First, Rest...>
+    : std::integral_constant<size_t, 1 + TuyaDPIndexOf<DP, Rest...>::value> {};
+
+// MARK: - Schema
+/// the datapoints of a device profile and the last decoded value of each received one, in fixed typed storage
+template<typename... DPs>
+class TuyaDPSchema {
+public:
+    static constexpr size_t numberOfDataPoints = sizeof...(DPs);
+
+private:
+    static_assert(sizeof...(DPs) > 0, "a schema needs at least one datapoint");
+    static_assert(TuyaDPIdsAreUnique<DPs::id...>::value, "a datapoint id is declared twice in a schema");
+
+    std::tuple<typename DPs::Storage...> _values;
+    std::bitset<sizeof...(DPs)> _isDecoded;
+
+    template<typename DP>
+    static constexpr bool isInSchema() { return TuyaDPIndexOf<DP, DPs...>::value < sizeof...(DPs); }
+
+    template<typename DP>
+    static constexpr size_t indexOf() { return TuyaDPIndexOf<DP, DPs...>::value; }
+
+    /// the dispatch, unrolled at compile time into a comparison of the id with each datapoint of the schema.
+    /// Datapoints we only send have no decoder, so reports of them are ignored like those of unknown datapoints
+    template<size_t Index>
+    TuyaDPDecodeResult decodeFrom(const TuyaDataPoint& dataPoint, std::integral_constant<size_t, Index>) {
+        typedef typename std::tuple_element<Index, std::tuple<DPs...>>::type DP;
+        if(dataPoint.dp() != DP::id) return decodeFrom(dataPoint, std::integral_constant<size_t, Index + 1>());
+        return decodeInto<Index, DP>(dataPoint, std::integral_constant<bool, DP::canReceive>());
+    }
+
+    TuyaDPDecodeResult decodeFrom(const TuyaDataPoint&, std::integral_constant<size_t, sizeof...(DPs)>) { return TuyaDPDecodeResult::notInSchema; }
+
+    template<size_t Index, typename DP>
+    TuyaDPDecodeResult decodeInto(const TuyaDataPoint& dataPoint, std::true_type) {
+        if(dataPoint.type() != DP::type) return TuyaDPDecodeResult::notInSchema;
+        bool hasChanged = DP::Traits::store(dataPoint, std::get<Index>(_values)) || !_isDecoded.test(Index);
+        _isDecoded.set(Index);
+        return hasChanged ? TuyaDPDecodeResult::changed : TuyaDPDecodeResult::unchanged;
+    }
+
+    template<size_t Index, typename DP>
+    TuyaDPDecodeResult decodeInto(const TuyaDataPoint&, std::false_type) { return TuyaDPDecodeResult::notInSchema; }
+
+public:
+    /// stores a received datapoint in typed storage, if it's received according to the schema and has the declared type
+    TuyaDPDecodeResult decode(const TuyaDataPoint& dataPoint) { return decodeFrom(dataPoint, std::integral_constant<size_t, 0>()); }
+
+    /// forgets all decoded values
+    void clear() { _isDecoded.reset(); }
+
+    /// whether a value of `DP` has been decoded
+    template<typename DP>
+    bool has() const {
+        static_assert(isInSchema<DP>(), "datapoint isn't part of this schema");
+        static_assert(DP::canReceive, "datapoint is never received, so it has no value");
+        return _isDecoded.test(indexOf<DP>());
+    }
+
+    /// the last decoded value of `DP`, or `defaultValue` if none has been decoded. Raw and bitmap
+    /// values are views on the schema's storage, valid until the datapoint is decoded again
+    template<typename DP>
+    typename DP::Value get(typename DP::Value defaultValue) const {
+        static_assert(isInSchema<DP>(), "datapoint isn't part of this schema");
+        static_assert(DP::canReceive, "datapoint is never received, so it has no value");
+        return _isDecoded.test(indexOf<DP>()) ? DP::Traits::load(std::get<indexOf<DP>()>(_values)) : defaultValue;
+    }
+
+    /// a datapoint with `value`, ready to be sent
+    template<typename DP>
+    static TuyaDataPoint make(typename DP::Value value) {
+        static_assert(isInSchema<DP>(), "datapoint isn't part of this schema");
+        static_assert(DP::canSend, "datapoint is never sent");
+        return DP::Traits::encode(DP::id, value);
+    }
+};
+
+#endif//TUYA_DATAPOINT_SCHEMA_123
@@ -0,0 +1,136 @@
+#ifndef TUYA_DATAPOINT_STORE_123
+#define TUYA_DATAPOINT_STORE_123
+
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "TuyaDataPoint.h"
+
+/// A set of datapoint ids, as a 256 bit bitmap
+class TuyaDataPointIdSet {
+public:
+    static const size_t numberOfIds = 256;
+
+private:
+    uint32_t _bits[numberOfIds / 32] = {};
+
+public:
+    bool contains(uint8_t dp) const { return (_bits[dp / 32] & (uint32_t(1) << (dp % 32))) != 0; }
+    void insert(uint8_t dp) { _bits[dp / 32] |= (uint32_t(1) << (dp % 32)); }
+    void remove(uint8_t dp) { _bits[dp / 32] &= ~(uint32_t(1) << (dp % 32)); }
+
+    void clear() {
+        for(auto& word : _bits) word = 0;
+    }
+
+    bool isEmpty() const {
+        for(auto word : _bits) {
+            if(word != 0) return false;
+        }
+        return true;
+    }
+
+    size_t size() const {
+        size_t count = 0;
+        for(auto word : _bits) count += __builtin_popcount(word);
+        return count;
+    }
+
+    /// calls `visitor` with every id in the set, in ascending order
+    template<typename Visitor>
+    void forEach(Visitor visitor) const {
+        for(size_t word = 0; word < numberOfIds / 32; word++) {
+            for(uint32_t bits = _bits[word]; bits != 0; bits &= bits - 1) {
+                visitor(static_cast<uint8_t>(word * 32 + __builtin_ctz(bits)));
+            }
+        }
+    }
+};
+
+/// The datapoints reported by a device, at most one per id.
+///
+/// Datapoint ids are a single byte, so the store is indexed directly by id: a presence bitmap tells
+/// whether an id is stored and a 256 entry table where. The datapoints themselves are kept next to
+/// each other in 256 slots, so finding one is two array reads and storing one doesn't allocate a node.
+/// The slots are allocated up front and never move: a stored datapoint (and a view on its payload)
+/// stays valid until a datapoint with the same id is stored, or the store is cleared.
+class TuyaDataPointStore {
+public:
+    static const size_t numberOfIds = TuyaDataPointIdSet::numberOfIds;
+
+private:
+    TuyaDataPointIdSet _presence;
+    uint8_t _indexById[numberOfIds] = {};
+    std::vector<TuyaDataPoint> _dataPoints;
+
+public:
+    // a slot for every id, so adding a datapoint never reallocates
+    TuyaDataPointStore() { _dataPoints.reserve(numberOfIds); }
+    TuyaDataPointStore(const TuyaDataPointStore& other) : TuyaDataPointStore() { *this = other; }
+
+    TuyaDataPointStore& operator=(const TuyaDataPointStore& other) {
+        _presence = other._presence;
+        std::copy(other._indexById, other._indexById + numberOfIds, _indexById);
+        // assigning reuses the reserved slots
+        _dataPoints.assign(other._dataPoints.begin(), other._dataPoints.end());
+        return *this;
+    }
+
+    bool contains(uint8_t dp) const { return _presence.contains(dp); }
+    const TuyaDataPointIdSet& ids() const { return _presence; }
+    size_t size() const { return _dataPoints.size(); }
+    bool isEmpty() const { return _dataPoints.empty(); }
+
+    /// the stored datapoint with id `dp` or nullptr, valid until `dp` is set again or the store is cleared
+    const TuyaDataPoint* find(uint8_t dp) const {
+        return contains(dp) ? &_dataPoints[_indexById[dp]] : nullptr;
+    }
+
+    /// the stored datapoint with id `dp` if it is of `type`, otherwise nullptr
+    const TuyaDataPoint* find(uint8_t dp, TuyaDataPointType type) const {
+        const TuyaDataPoint* dataPoint = find(dp);
+        return dataPoint != nullptr && dataPoint->type() == type ? dataPoint : nullptr;
+    }
+
+    /// stores `dataPoint`, replacing the stored datapoint with the same id. Returns true if that
+    /// changed the store: there was no datapoint with this id yet, or it had another type or value
+    bool set(const TuyaDataPoint& dataPoint) {
+        uint8_t dp = dataPoint.dp();
+        if(contains(dp)) {
+            TuyaDataPoint& stored = _dataPoints[_indexById[dp]];
+            if(stored == dataPoint) return false;
+            stored = dataPoint;
+        } else {
+            _indexById[dp] = static_cast<uint8_t>(_dataPoints.size());
+            _dataPoints.push_back(dataPoint);
+            _presence.insert(dp);
+        }
+        return true;
+    }
+
+    void clear() {
+        _presence.clear();
+        _dataPoints.clear();
+    }
+
+    /// calls `visitor` with every stored datapoint in order of id, without copying them
+    template<typename Visitor>
+    void forEach(Visitor visitor) const {
+        _presence.forEach([this, &visitor](uint8_t dp) {
+            visitor(_dataPoints[_indexById[dp]]);
+        });
+    }
+
+    /// a copy of all stored datapoints, keyed by id
+    std::map<uint8_t, TuyaDataPoint> toMap() const {
+        std::map<uint8_t, TuyaDataPoint> output;
+        forEach([&output](const TuyaDataPoint& dataPoint) {
+            output.insert(std::pair<uint8_t, TuyaDataPoint>(dataPoint.dp(), dataPoint));
+        });
+        return output;
+    }
+};
+
+#endif//TUYA_DATAPOINT_STORE_123
@@ -0,0 +1,45 @@
+#ifndef TEST_SUPPORT_1234
+#define TEST_SUPPORT_1234
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+
+/// Shared by the test suites in `test/`, which run on the host (`pio test -e native`) and on an ESP32 (`pio test -e esp32`).
+
+/// true if `pointer` points into `object` itself, e.g. a buffer's bytes that are stored inline
+template<typename T>
+bool isInside(const T& object, const void* pointer) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&object);
+    const uint8_t* bytePointer = static_cast<const uint8_t*>(pointer);
+    return bytePointer >= bytes && bytePointer < bytes + sizeof(T);
+}
+
+/// runs `body` `iterations` times and reports the average time per iteration
+template<typename Body>
+void benchmark(const char* name, uint32_t iterations, Body body) {
+    unsigned long start = micros();
+    for(uint32_t iteration = 0; iteration < iterations; iteration++) {
+        body();
+    }
+    unsigned long elapsed = micros() - start;
+
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %.3f us", name, static_cast<double>(elapsed) / iterations);
+    TEST_MESSAGE(message);
+}
+
+void setUp() {}
+void tearDown() {}
+
+/// the entry point of a test suite: `runTests` calls UNITY_BEGIN(), RUN_TEST() for each test and returns UNITY_END()
+#if defined(ARDUINO)
+    #define TEST_SUITE_MAIN(runTests) \
+        void setup() { delay(2000); runTests(); } \
+        void loop() {}
+#else
+    #define TEST_SUITE_MAIN(runTests) \
+        int main() { return runTests(); }
+#endif
+
+#endif//TEST_SUPPORT_1234
@@ -0,0 +1,54 @@
+#ifndef HOST_ALLOCATION_COUNTER_1234
+#define HOST_ALLOCATION_COUNTER_1234
+
+/// Counts heap allocations on the host, by putting malloc() and friends in front of the C library's.
+/// operator new goes through malloc(), so vectors, strings and std::functions are counted too.
+///
+/// This defines the allocation functions, so include it from a single file of a test program: its `test_main.cpp`.
+/// Only glibc lets us call through to its own allocator, elsewhere `isAvailable()` is false and nothing is counted.
+
+#include <stddef.h>
+#include <stdlib.h>
+
+namespace AllocationCounter {
+    static size_t numberOfAllocations = 0;
+
+#if defined(__GLIBC__)
+    inline bool isAvailable() { return true; }
+#else
+    inline bool isAvailable() { return false; }
+#endif
+
+    /// the number of heap allocations made by `body`
+    template<typename Body>
+    size_t count(Body body) {
+        size_t start = numberOfAllocations;
+        body();
+        return numberOfAllocations - start;
+    }
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+
+    void* malloc(size_t size) {
+        AllocationCounter::numberOfAllocations += 1;
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) {
+        AllocationCounter::numberOfAllocations += 1;
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size) {
+        AllocationCounter::numberOfAllocations += 1;
+        return __libc_realloc(pointer, size);
+    }
+}
+#endif
+
+#endif//HOST_ALLOCATION_COUNTER_1234
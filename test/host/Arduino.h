@@ -0,0 +1,72 @@
+#ifndef HOST_ARDUINO_1234
+#define HOST_ARDUINO_1234
+
+/// Just enough of the Arduino core to build the portable parts of the library on the host
+/// (`pio test -e native`): buffers, datapoints, CRC, the reference crypto backend, the frame encoder, the request table
+/// and the transmit queue, the last two with the FreeRTOS stand-ins in `freertos/`. Everything that talks to NimBLE is left out of the native build.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+typedef bool boolean;
+
+#define HEX 16
+#define DEC 10
+
+class String {
+private:
+    std::string _string;
+
+    template<typename T> static std::string format(T value, unsigned char base) {
+        char output[24];
+        snprintf(output, sizeof(output), base == HEX ? "%llx" : "%lld", static_cast<long long>(value));
+        return output;
+    }
+
+public:
+    String() {}
+    String(const char* string) : _string(string != nullptr ? string : "") {}
+    String(const char* string, unsigned int length) : _string(string, length) {}
+    String(const std::string& string) : _string(string) {}
+    explicit String(char value) : _string(1, value) {}
+    explicit String(int value, unsigned char base = DEC) : _string(format(value, base)) {}
+    explicit String(unsigned int value, unsigned char base = DEC) : _string(format(value, base)) {}
+    explicit String(long value, unsigned char base = DEC) : _string(format(value, base)) {}
+    explicit String(unsigned long value, unsigned char base = DEC) : _string(format(value, base)) {}
+    explicit String(unsigned char value, unsigned char base = DEC) : _string(format(value, base)) {}
+
+    const char* c_str() const { return _string.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(_string.size()); }
+    String substring(unsigned int from, unsigned int to) const { return String(_string.substr(from, to - from)); }
+
+    String& operator+=(const String& other) { _string += other._string; return *this; }
+    String& operator+=(const char* other) { _string += other; return *this; }
+    String& operator+=(char other) { _string += other; return *this; }
+
+    friend String operator+(const String& lhs, const String& rhs) { return String(lhs._string + rhs._string); }
+    friend String operator+(const String& lhs, const char* rhs) { return String(lhs._string + rhs); }
+    friend String operator+(const char* lhs, const String& rhs) { return String(lhs + rhs._string); }
+
+    bool operator==(const String& other) const { return _string == other._string; }
+    bool operator!=(const String& other) const { return _string != other._string; }
+};
+
+inline unsigned long micros() {
+    using namespace std::chrono;
+    return static_cast<unsigned long>(duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+inline unsigned long millis() { return micros() / 1000; }
+inline void delay(unsigned long milliseconds) { std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds)); }
+
+#define log_e(format, ...) fprintf(stderr, format "\n", ##__VA_ARGS__)
+
+#endif//HOST_ARDUINO_1234
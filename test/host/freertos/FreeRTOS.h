@@ -0,0 +1,21 @@
+#ifndef HOST_FREERTOS_1234
+#define HOST_FREERTOS_1234
+
+/// Just enough of FreeRTOS to build the transmit queue and the request table on the host (`pio test -e native`).
+/// Semaphores are backed by the standard library. Tasks can't be created, so the transmit queue
+/// writes messages on the caller's task, as it does on a device that's out of memory for its task.
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL 0
+#define pdPASS 1
+#define portMAX_DELAY static_cast<TickType_t>(0xFFFFFFFF)
+#define pdMS_TO_TICKS(milliseconds) static_cast<TickType_t>(milliseconds)
+
+#endif//HOST_FREERTOS_1234
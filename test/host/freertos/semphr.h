@@ -0,0 +1,55 @@
+#ifndef HOST_FREERTOS_SEMPHR_1234
+#define HOST_FREERTOS_SEMPHR_1234
+
+#include "FreeRTOS.h"
+
+#include <condition_variable>
+#include <mutex>
+
+/// a mutex (recursive or not, the host doesn't tell them apart) or a binary semaphore
+struct HostSemaphore {
+    bool isBinary;
+    std::recursive_mutex mutex;
+    std::mutex countMutex;
+    std::condition_variable countChanged;
+    bool isGiven = false;
+
+    explicit HostSemaphore(bool isBinary) : isBinary(isBinary) {}
+};
+
+typedef HostSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new HostSemaphore(false); }
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return new HostSemaphore(false); }
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return new HostSemaphore(true); }
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+
+/// only waiting forever is supported
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t) {
+    if(!semaphore->isBinary) {
+        semaphore->mutex.lock();
+        return pdTRUE;
+    }
+
+    std::unique_lock<std::mutex> lock(semaphore->countMutex);
+    semaphore->countChanged.wait(lock, [semaphore]() { return semaphore->isGiven; });
+    semaphore->isGiven = false;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if(!semaphore->isBinary) {
+        semaphore->mutex.unlock();
+        return pdTRUE;
+    }
+
+    std::lock_guard<std::mutex> lock(semaphore->countMutex);
+    semaphore->isGiven = true;
+    semaphore->countChanged.notify_one();
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks) { return xSemaphoreTake(semaphore, ticks); }
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore) { return xSemaphoreGive(semaphore); }
+
+#endif//HOST_FREERTOS_SEMPHR_1234
@@ -0,0 +1,20 @@
+#ifndef HOST_FREERTOS_TASK_1234
+#define HOST_FREERTOS_TASK_1234
+
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* parameter);
+
+/// there are no tasks on the host, callers fall back to doing the work themselves
+inline BaseType_t xTaskCreate(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t, TaskHandle_t* task) {
+    if(task != nullptr) *task = nullptr;
+    return pdFAIL;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+inline void vTaskDelete(TaskHandle_t) {}
+inline BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+#endif//HOST_FREERTOS_TASK_1234
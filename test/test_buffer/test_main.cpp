@@ -0,0 +1,343 @@
+#include "../TestSupport.h"
+
+#ifndef ARDUINO
+#include "AllocationCounter.h"
+#endif
+
+#include "Buffer.h"
+#include "BufferArena.h"
+#include "BufferView.h"
+#include "ByteReader.h"
+#include "Crc16.h"
+#include "CryptoHelper.h"
+#include "TuyaBLEDataPointReport.h"
+#include "TuyaBLEDeviceStatistics.h"
+#include "TuyaBLEFrameEncoder.h"
+#include "TuyaBLEMessageReassembler.h"
+#include "TuyaBLEReceivedMessage.h"
+#include "TuyaBLERequestTable.h"
+#include "TuyaBLETransmitQueue.h"
+#include "TuyaDataPoint.h"
+#include "TuyaDataPointStore.h"
+
+// MARK: - Inline storage
+
+void testSmallPayloadsStayInline() {
+    // a GATT packet, an IV or MD5 digest, a key prefix and a full inline buffer
+    for(size_t length : {size_t(20), size_t(16), size_t(6), Buffer::inlineCapacity}) {
+        Buffer buffer(length);
+        TEST_ASSERT_EQUAL(length, buffer.size());
+        TEST_ASSERT_TRUE(isInside(buffer, buffer.data()));
+
+        Buffer copy = buffer;
+        TEST_ASSERT_TRUE(isInside(copy, copy.data()));
+
+        Buffer moved = std::move(copy);
+        TEST_ASSERT_TRUE(isInside(moved, moved.data()));
+        TEST_ASSERT_EQUAL(length, moved.size());
+    }
+}
+
+void testLargePayloadsMoveToTheHeap() {
+    Buffer buffer(Buffer::inlineCapacity + 1);
+    TEST_ASSERT_FALSE(isInside(buffer, buffer.data()));
+
+    // moving takes the heap storage over instead of copying it
+    const uint8_t* storage = buffer.data();
+    Buffer moved = std::move(buffer);
+    TEST_ASSERT_TRUE(moved.data() == storage);
+    TEST_ASSERT_EQUAL(0, buffer.size());
+    TEST_ASSERT_TRUE(isInside(buffer, buffer.data()));
+}
+
+void testGrowingReallocatesGeometrically() {
+    Buffer buffer;
+    size_t numberOfAllocations = 0;
+    const uint8_t* storage = buffer.data();
+    for(size_t index = 0; index < 1024; index++) {
+        buffer.append(static_cast<uint8_t>(index));
+        if(buffer.data() != storage) {
+            numberOfAllocations += 1;
+            storage = buffer.data();
+        }
+    }
+
+    // 32 -> 64 -> 128 -> 256 -> 512 -> 1024
+    TEST_ASSERT_EQUAL(5, numberOfAllocations);
+    for(size_t index = 0; index < 1024; index++) {
+        TEST_ASSERT_EQUAL(static_cast<uint8_t>(index), buffer[index]);
+    }
+}
+
+void testReserveAvoidsReallocations() {
+    Buffer buffer;
+    buffer.reserve(300);
+    const uint8_t* storage = buffer.data();
+    buffer.appendRepeated(0xAA, 300);
+    TEST_ASSERT_TRUE(buffer.data() == storage);
+
+    // clearing keeps the capacity around
+    buffer.clear();
+    buffer.appendRepeated(0xBB, 300);
+    TEST_ASSERT_TRUE(buffer.data() == storage);
+}
+
+// MARK: - Arena
+
+void testArenaBuffersDontUseTheHeap() {
+    BufferArena arena(1024);
+    {
+        BufferArenaScope scope(arena);
+        Buffer buffer(arena);
+        buffer.appendRepeated(0x11, 200);
+        TEST_ASSERT_TRUE(arena.owns(buffer.data()));
+        TEST_ASSERT_GREATER_THAN(0, arena.used());
+
+        // copying out of the scope copies the bytes to the heap
+        Buffer escaped = buffer;
+        TEST_ASSERT_FALSE(arena.owns(escaped.data()));
+        TEST_ASSERT_EQUAL(buffer.size(), escaped.size());
+        TEST_ASSERT_EQUAL_MEMORY(buffer.data(), escaped.data(), buffer.size());
+    }
+    TEST_ASSERT_EQUAL(0, arena.used());
+}
+
+void testExhaustedArenaFallsBackToTheHeap() {
+    BufferArena arena(64);
+    BufferArenaScope scope(arena);
+    Buffer buffer(arena);
+    buffer.appendRepeated(0x22, 100);
+    TEST_ASSERT_FALSE(arena.owns(buffer.data()));
+    TEST_ASSERT_EQUAL(100, buffer.size());
+}
+
+// MARK: - API
+
+void testAppendAndRead() {
+    Buffer buffer;
+    buffer.append(static_cast<uint8_t>(0x01));
+    buffer.appendBigEndian(static_cast<uint16_t>(0x0203));
+    buffer.appendBigEndian(static_cast<int32_t>(-2));
+    buffer.appendLittleEndian(static_cast<uint16_t>(0x0405));
+    buffer.appendBigEndianWithNumberOfBytes(0x0607, 2);
+
+    const uint8_t expected[] = {0x01, 0x02, 0x03, 0xFF, 0xFF, 0xFF, 0xFE, 0x05, 0x04, 0x06, 0x07};
+    TEST_ASSERT_EQUAL(sizeof(expected), buffer.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, buffer.data(), sizeof(expected));
+
+    TEST_ASSERT_EQUAL_INT32(-2, buffer.subRangeWithStartAndLength(3, 4).asBigEndianSignedInt());
+    TEST_ASSERT_EQUAL_UINT32(0x0203, buffer.view().subRangeWithStartAndLength(1, 2).asBigEndianUnsignedInt());
+}
+
+void testPackedIntRoundTrips() {
+    for(unsigned int value : {0u, 1u, 127u, 128u, 300u, 16383u, 16384u, 0xFFFFFFFFu}) {
+        Buffer buffer;
+        buffer.appendPackedInt(value);
+        size_t offset = 0;
+        TEST_ASSERT_EQUAL_UINT32(value, buffer.readPackedInt(offset));
+        TEST_ASSERT_EQUAL(buffer.size(), offset);
+    }
+}
+
+void testPadToNumberOfBytes() {
+    Buffer buffer({1, 2, 3});
+    buffer.padToNumberOfBytes(16);
+    TEST_ASSERT_EQUAL(16, buffer.size());
+    TEST_ASSERT_EQUAL(0, buffer[15]);
+}
+
+// MARK: - Benchmarks
+
+void benchmarkBuffers() {
+    uint8_t packet[20] = {};
+    benchmark("build a 20 byte packet", 10000, [&packet]() {
+        Buffer buffer;
+        buffer.appendPackedInt(1);
+        buffer.append(packet, sizeof(packet) - 1);
+    });
+
+    benchmark("append 512 bytes one by one", 1000, []() {
+        Buffer buffer;
+        for(size_t index = 0; index < 512; index++) buffer.append(static_cast<uint8_t>(index));
+    });
+
+    BufferArena arena(1024);
+    benchmark("append 512 bytes one by one in an arena", 1000, [&arena]() {
+        BufferArenaScope scope(arena);
+        Buffer buffer(arena);
+        for(size_t index = 0; index < 512; index++) buffer.append(static_cast<uint8_t>(index));
+    });
+}
+
+// MARK: - Allocations per message
+
+static const uint8_t keyBytes[16] = {0x00, 0x07, 0x0E, 0x15, 0x1C, 0x23, 0x2A, 0x31, 0x38, 0x3F, 0x46, 0x4D, 0x54, 0x5B, 0x62, 0x69};
+static const uint8_t iv[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+
+/// the parts of `TuyaBLEDevice` a datapoints write goes through, with the BLE write stubbed out.
+/// There are no tasks on the host, so the queue writes the packets from `enqueue()`
+struct SendPath {
+    BufferArena arena{512};
+    TuyaBLETransmitQueue queue;
+    TuyaBLERequestTable requests;
+    AesCbc128Key key{keyBytes};
+    size_t numberOfWrittenPackets = 0;
+    size_t numberOfSentMessages = 0;
+    size_t numberOfConfirmedWrites = 0;
+
+    SendPath() {
+        TuyaBLETransmitQueue::Configuration configuration;
+        configuration.creditIntervalMs = 0;
+        queue.setConfiguration(configuration);
+        queue.start([this](const uint8_t*, size_t) {
+            numberOfWrittenPackets += 1;
+            return true;
+        }, [this](uint32_t, bool success) {
+            if(success) numberOfSentMessages += 1;
+        });
+    }
+
+    /// as `transmitDataPoints()` and `sendRequest()`: encodes the datapoints, registers the request and
+    /// encodes the message straight into the queue, which writes it
+    void send(const std::vector<TuyaDataPoint>& dps, uint32_t sequenceNumber) {
+        BufferArenaScope scope(arena);
+        Buffer data(arena);
+        for(auto&& dataPoint : dps)
+            dataPoint.encode(data, 1);
+
+        TuyaBLERequestTable::Request request;
+        request.sequenceNumber = sequenceNumber;
+        request.code = TuyaBLEFunctionCode::senderDps;
+        request.timeoutMs = 5000;
+        request.handler = [this](TuyaBLERequestStatus status, const TuyaBLEReceivedMessage*, const TuyaBLERequestTable::Request& completedRequest) {
+            if(status == TuyaBLERequestStatus::success) numberOfConfirmedWrites += 1;
+            for(auto&& callback : completedRequest.statusCallbacks)
+                callback(nullptr, status);
+        };
+        TEST_ASSERT_TRUE(requests.add(request, millis()));
+
+        TEST_ASSERT_TRUE(queue.enqueue([&](TuyaBLEEncodedFrame& frame) {
+            TuyaBLEFrameEncoder::encode(frame, TuyaBLESecurityFlag::sessionKey, key, iv, sequenceNumber, 0, TuyaBLEFunctionCode::senderDps, data, 3, 20);
+        }, sequenceNumber));
+    }
+
+    /// the device's response completes the request
+    void confirm(uint32_t sequenceNumber) {
+        TuyaBLEReceivedMessage response;
+        response.functionCode = TuyaBLEFunctionCode::senderDps;
+        TEST_ASSERT_TRUE(requests.complete(response, sequenceNumber));
+    }
+};
+
+/// from `onNotify()` to `handleReceivedDataPoints()` with the packets of a receiveDp report. Reassembling, parsing the
+/// report and storing its datapoints use the library's classes, decrypting and reading the frame header do what `TuyaBLEDevice` does
+static size_t receiveDp(const TuyaBLEEncodedFrame& packets, const AesCbc128Key& key, TuyaBLEMessageReassembler& reassembler,
+    BufferArena& arena, TuyaDataPointStore& store) {
+    TuyaBLEDeviceStatistics statistics;
+    for(size_t index = 0; index < packets.numberOfPackets(); index++) {
+        if(reassembler.addPacket(packets.packet(index), 0, statistics) != TuyaBLEMessageReassembler::Result::complete)
+            continue;
+
+        BufferArenaScope scope(arena);
+        Buffer& frame = reassembler.message();
+        key.decryptInPlace(frame.data() + 1, frame.data() + 17, frame.size() - 17);
+
+        ByteReader reader(BufferView(frame.data() + 17, frame.size() - 17));
+        TuyaBLEReceivedMessage message;
+        message.sequenceNumber = reader.readBigEndianUint32();
+        message.responseToSequenceNumber = reader.readBigEndianUint32();
+        message.functionCode = static_cast<TuyaBLEFunctionCode>(reader.readBigEndianUint16());
+        message.data = reader.readBuffer(reader.readBigEndianUint16());
+        size_t checkedLength = reader.offset();
+        if(reader.readBigEndianUint16() != Crc16::compute(frame.data() + 17, checkedLength))
+            return 0;
+
+        TuyaBLEDataPointReport report;
+        TuyaBLEReceivedDataPointItems items{BufferArenaAllocator<TuyaBLEReceivedDataPointItem>(&arena)};
+        if(!report.parse(message) || !report.parseItems(items))
+            return 0;
+
+        for(auto&& item : items)
+            store.set(item.toDataPoint());
+        return items.size();
+    }
+    return 0;
+}
+
+void benchmarkAllocationsOfTheMessagePaths() {
+#ifdef ARDUINO
+    TEST_MESSAGE("allocations are only counted on the host");
+#else
+    if(!AllocationCounter::isAvailable()) {
+        TEST_MESSAGE("allocations can't be counted with this C library");
+        return;
+    }
+
+    char message[160];
+
+    // a boolean, a value and an 8 byte raw datapoint, without a status callback. The first messages allocate the arena
+    // and the frames of the queue's entries, which it goes through in turn, later messages reuse them
+    SendPath sendPath;
+    std::vector<TuyaDataPoint> dps{TuyaDataPoint::boolean(1, true), TuyaDataPoint::value(2, 300), TuyaDataPoint::raw(3, Buffer({1, 2, 3, 4, 5, 6, 7, 8}))};
+    uint32_t sequenceNumber = 1;
+    for(; sequenceNumber <= sendPath.queue.configuration().maximumNumberOfQueuedMessages; sequenceNumber++) {
+        sendPath.send(dps, sequenceNumber);
+        sendPath.confirm(sequenceNumber);
+    }
+    size_t sendAllocations = AllocationCounter::count([&]() {
+        sendPath.send(dps, sequenceNumber);
+        sendPath.confirm(sequenceNumber);
+    });
+    TEST_ASSERT_EQUAL(sequenceNumber, sendPath.numberOfSentMessages);
+    TEST_ASSERT_EQUAL(sequenceNumber, sendPath.numberOfConfirmedWrites);
+    TEST_ASSERT_GREATER_THAN(1, sendPath.numberOfWrittenPackets);
+    snprintf(message, sizeof(message), "allocations to encode, queue, write and complete a senderDps request: %u",
+        static_cast<unsigned>(sendAllocations));
+    TEST_MESSAGE(message);
+    TEST_ASSERT_EQUAL(0, sendAllocations);
+
+    // a 55 byte receiveDp report in 6 packets: a boolean, a value, an enum, a 24 byte raw and a 10 character string
+    AesCbc128Key key(keyBytes);
+    BufferArena receiveArena(1024);
+    TuyaBLEMessageReassembler reassembler;
+    TuyaDataPointStore store;
+    Buffer items;
+    items.append({1, 1, 1, 1});
+    items.append({8, 2, 4, 0, 0, 0, 87});
+    items.append({9, 4, 1, 2});
+    items.append({12, 0, 24});
+    for(uint8_t index = 0; index < 24; index++) items.append(index);
+    items.append({13, 3, 10});
+    items.append(String("front door"));
+    TuyaBLEEncodedFrame packets;
+    TuyaBLEFrameEncoder::encode(packets, TuyaBLESecurityFlag::sessionKey, key, iv, 7, 0, TuyaBLEFunctionCode::receiveDp, items, 3, 20);
+
+    TEST_ASSERT_EQUAL(5, receiveDp(packets, key, reassembler, receiveArena, store));
+    size_t receivedDataPoints = 0;
+    size_t receiveAllocations = AllocationCounter::count([&]() { receivedDataPoints = receiveDp(packets, key, reassembler, receiveArena, store); });
+    TEST_ASSERT_EQUAL(5, receivedDataPoints);
+    snprintf(message, sizeof(message), "allocations to reassemble, decrypt and store a receiveDp report: %u",
+        static_cast<unsigned>(receiveAllocations));
+    TEST_MESSAGE(message);
+    // the 24 byte raw datapoint is too large for a `TuyaDataPoint` to keep inline
+    TEST_ASSERT_LESS_OR_EQUAL(1, receiveAllocations);
+#endif
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testSmallPayloadsStayInline);
+    RUN_TEST(testLargePayloadsMoveToTheHeap);
+    RUN_TEST(testGrowingReallocatesGeometrically);
+    RUN_TEST(testReserveAvoidsReallocations);
+    RUN_TEST(testArenaBuffersDontUseTheHeap);
+    RUN_TEST(testExhaustedArenaFallsBackToTheHeap);
+    RUN_TEST(testAppendAndRead);
+    RUN_TEST(testPackedIntRoundTrips);
+    RUN_TEST(testPadToNumberOfBytes);
+    RUN_TEST(benchmarkBuffers);
+    RUN_TEST(benchmarkAllocationsOfTheMessagePaths);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
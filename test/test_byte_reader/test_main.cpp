@@ -0,0 +1,71 @@
+#include "../TestSupport.h"
+
+#include "Buffer.h"
+#include "BufferView.h"
+#include "ByteReader.h"
+
+void testReadsInBounds() {
+    const uint8_t bytes[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+    ByteReader reader(BufferView(bytes, sizeof(bytes)));
+
+    TEST_ASSERT_EQUAL_UINT8(0x01, reader.readUint8());
+    TEST_ASSERT_EQUAL_UINT16(0x0203, reader.readBigEndianUint16());
+    TEST_ASSERT_EQUAL_UINT32(0x07060504, reader.readLittleEndianUint32());
+    TEST_ASSERT_TRUE(reader.isAtEnd());
+    TEST_ASSERT_TRUE(reader.isValid());
+}
+
+void testReadingPastTheEndFailsAndSticks() {
+    const uint8_t bytes[] = {0x01, 0x02, 0x03};
+    ByteReader reader(BufferView(bytes, sizeof(bytes)));
+
+    TEST_ASSERT_EQUAL_UINT32(0, reader.readBigEndianUint32());
+    TEST_ASSERT_TRUE(reader.hasError());
+
+    // nothing can be read after an error, even what would fit
+    TEST_ASSERT_EQUAL_UINT8(0, reader.readUint8());
+    TEST_ASSERT_EQUAL(0, reader.readBuffer(1).size());
+    TEST_ASSERT_TRUE(reader.hasError());
+}
+
+void testPackedInts() {
+    for(unsigned int value : {0u, 127u, 128u, 16384u, 0x0FFFFFFFu, 0xFFFFFFFFu}) {
+        Buffer buffer;
+        buffer.appendPackedInt(value);
+        ByteReader reader(buffer.view());
+        TEST_ASSERT_EQUAL_UINT32(value, reader.readPackedInt());
+        TEST_ASSERT_TRUE(reader.isAtEnd());
+        TEST_ASSERT_TRUE(reader.isValid());
+    }
+}
+
+void testPackedIntLimits() {
+    // 300 takes 2 bytes
+    const uint8_t twoBytes[] = {0xAC, 0x02};
+    ByteReader shortReader(BufferView(twoBytes, sizeof(twoBytes)));
+    TEST_ASSERT_EQUAL_UINT32(0, shortReader.readPackedInt(1));
+    TEST_ASSERT_TRUE(shortReader.hasError());
+
+    // more than 32 bits
+    const uint8_t tooLarge[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x1F};
+    ByteReader largeReader(BufferView(tooLarge, sizeof(tooLarge)));
+    TEST_ASSERT_EQUAL_UINT32(0, largeReader.readPackedInt());
+    TEST_ASSERT_TRUE(largeReader.hasError());
+
+    // never terminated; a larger maximum is capped at 5 bytes instead of shifting past 32 bits
+    const uint8_t unterminated[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+    ByteReader unterminatedReader(BufferView(unterminated, sizeof(unterminated)));
+    TEST_ASSERT_EQUAL_UINT32(0, unterminatedReader.readPackedInt(sizeof(unterminated)));
+    TEST_ASSERT_TRUE(unterminatedReader.hasError());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testReadsInBounds);
+    RUN_TEST(testReadingPastTheEndFailsAndSticks);
+    RUN_TEST(testPackedInts);
+    RUN_TEST(testPackedIntLimits);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
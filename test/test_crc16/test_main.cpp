@@ -0,0 +1,106 @@
+#include "../TestSupport.h"
+
+#include "Crc16.h"
+#include "CryptoHelper.h"
+
+static uint8_t testData[600];
+
+static void fillTestData() {
+    uint32_t state = 0x12345678;
+    for(auto& byte : testData) {
+        state = state * 1664525 + 1013904223;
+        byte = static_cast<uint8_t>(state >> 24);
+    }
+}
+
+void testCheckValue() {
+    // the standard CRC-16/MODBUS check value
+    const uint8_t digits[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    TEST_ASSERT_EQUAL_HEX16(0x4B37, Crc16::computeBitwise(digits, sizeof(digits)));
+    TEST_ASSERT_EQUAL_HEX16(0x4B37, Crc16::computeBytewise(digits, sizeof(digits)));
+    TEST_ASSERT_EQUAL_HEX16(0x4B37, Crc16::compute(digits, sizeof(digits)));
+}
+
+void testSliceBy4MatchesBytewiseAndBitwise() {
+    // every length, so every tail of 0-3 bytes after the 4 byte slices is covered, at every alignment
+    for(size_t offset = 0; offset < 4; offset++) {
+        for(size_t length = 0; length <= 300; length++) {
+            uint16_t bitwise = Crc16::computeBitwise(testData + offset, length);
+            TEST_ASSERT_EQUAL_HEX16(bitwise, Crc16::computeBytewise(testData + offset, length));
+            TEST_ASSERT_EQUAL_HEX16(bitwise, Crc16::compute(testData + offset, length));
+            TEST_ASSERT_EQUAL_HEX16(bitwise, CryptoHelper::crc16(testData + offset, length));
+        }
+    }
+}
+
+void testIncrementalUpdateMatchesOneShot() {
+    const size_t length = 100;
+    uint16_t expected = Crc16::computeBitwise(testData, length);
+    for(size_t split = 0; split <= length; split++) {
+        Crc16 crc;
+        crc.update(testData, split);
+        crc.update(BufferView(testData + split, length - split));
+        TEST_ASSERT_EQUAL_HEX16(expected, crc.value());
+    }
+
+    Crc16 crc;
+    for(size_t index = 0; index < length; index++) crc.update(testData[index]);
+    TEST_ASSERT_EQUAL_HEX16(expected, crc.value());
+
+    crc.reset();
+    TEST_ASSERT_EQUAL_HEX16(Crc16::seed, crc.value());
+}
+
+void testCopyAndUpdateMatchesUpdate() {
+    uint8_t copy[sizeof(testData)];
+    for(size_t length = 0; length <= 40; length++) {
+        for(size_t offset = 0; offset < 4; offset++) {
+            memset(copy, 0, sizeof(copy));
+            Crc16 crc;
+            crc.update(testData, 3);
+            crc.copyAndUpdate(copy + offset, testData + 3, length);
+            TEST_ASSERT_EQUAL_HEX16(Crc16::computeBitwise(testData, 3 + length), crc.value());
+            if(length > 0) TEST_ASSERT_EQUAL_MEMORY(testData + 3, copy + offset, length);
+            TEST_ASSERT_EQUAL_UINT8(0, copy[offset + length]);
+        }
+    }
+}
+
+void benchmarkCrc16() {
+    // about the size of a datapoint message and of a large raw datapoint
+    for(size_t length : {size_t(48), sizeof(testData)}) {
+        char name[64];
+        volatile uint16_t result = 0;
+
+        snprintf(name, sizeof(name), "bitwise, %u bytes", static_cast<unsigned>(length));
+        benchmark(name, 2000, [&]() { result = Crc16::computeBitwise(testData, length); });
+
+        snprintf(name, sizeof(name), "bytewise, %u bytes", static_cast<unsigned>(length));
+        benchmark(name, 2000, [&]() { result = Crc16::computeBytewise(testData, length); });
+
+        snprintf(name, sizeof(name), "slice-by-4, %u bytes", static_cast<unsigned>(length));
+        benchmark(name, 2000, [&]() { result = Crc16::compute(testData, length); });
+
+        uint8_t copy[sizeof(testData)];
+        snprintf(name, sizeof(name), "memcpy + slice-by-4, %u bytes", static_cast<unsigned>(length));
+        benchmark(name, 2000, [&]() { memcpy(copy, testData, length); result = Crc16::compute(copy, length); });
+
+        snprintf(name, sizeof(name), "copy and update, %u bytes", static_cast<unsigned>(length));
+        benchmark(name, 2000, [&]() { Crc16 crc; crc.copyAndUpdate(copy, testData, length); result = crc.value(); });
+        (void)result;
+    }
+}
+
+int runTests() {
+    fillTestData();
+
+    UNITY_BEGIN();
+    RUN_TEST(testCheckValue);
+    RUN_TEST(testSliceBy4MatchesBytewiseAndBitwise);
+    RUN_TEST(testIncrementalUpdateMatchesOneShot);
+    RUN_TEST(testCopyAndUpdateMatchesUpdate);
+    RUN_TEST(benchmarkCrc16);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
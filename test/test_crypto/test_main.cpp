@@ -0,0 +1,160 @@
+#include "../TestSupport.h"
+
+#include "Buffer.h"
+#include "CryptoBackend.h"
+#include "CryptoHelper.h"
+
+/// Every backend has to produce the published test vectors, so whichever one a build selects
+/// (see TUYA_BLE_CRYPTO_BACKEND) agrees with the others byte for byte.
+
+// NIST SP 800-38A, F.2.1 and F.2.5 (CBC-AES128 and CBC-AES256)
+static const uint8_t aes128Key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+static const uint8_t aes256Key[32] = {
+    0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81,
+    0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4,
+};
+
+static const uint8_t iv[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static const uint8_t plainText[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+static const uint8_t aes128CipherText[64] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+
+static const uint8_t aes256CipherText[64] = {
+    0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba, 0x77, 0x9e, 0xab, 0xfb, 0x5f, 0x7b, 0xfb, 0xd6,
+    0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb, 0x80, 0x8d, 0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d,
+    0x39, 0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf, 0xa5, 0x30, 0xe2, 0x63, 0x04, 0x23, 0x14, 0x61,
+    0xb2, 0xeb, 0x05, 0xe2, 0xc3, 0x9b, 0xe9, 0xfc, 0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b,
+};
+
+void testAes128Cbc() {
+    AesCbc128Key key(aes128Key);
+
+    Buffer encrypted = key.encrypt(iv, plainText, sizeof(plainText));
+    TEST_ASSERT_EQUAL_MEMORY(aes128CipherText, encrypted.data(), sizeof(aes128CipherText));
+
+    Buffer decrypted = key.decrypt(iv, aes128CipherText, sizeof(aes128CipherText));
+    TEST_ASSERT_EQUAL_MEMORY(plainText, decrypted.data(), sizeof(plainText));
+
+    // a single block, as the first block of a chain
+    Buffer block = CryptoHelper::aesCbc128Encrypt(aes128Key, iv, plainText, 16);
+    TEST_ASSERT_EQUAL_MEMORY(aes128CipherText, block.data(), 16);
+}
+
+void testAes128CbcInPlace() {
+    AesCbc128Key key(aes128Key);
+    uint8_t data[sizeof(plainText)];
+
+    memcpy(data, plainText, sizeof(data));
+    key.encryptInPlace(iv, data, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(aes128CipherText, data, sizeof(data));
+
+    key.decryptInPlace(iv, data, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(plainText, data, sizeof(data));
+
+    CryptoHelper::aesCbc128EncryptInPlace(aes128Key, iv, data, sizeof(data));
+    TEST_ASSERT_EQUAL_MEMORY(aes128CipherText, data, sizeof(data));
+}
+
+void testKeysDontShareState() {
+    // what two devices do when they encrypt at the same time, each with its own key
+    AesCbc128Key first(aes128Key);
+    AesCbc128Key second(aes256Key); // its first 16 bytes, just another key
+    Buffer firstBlock = first.encrypt(iv, plainText, 16);
+    Buffer secondBlock = second.encrypt(iv, plainText, 16);
+    Buffer firstMessage = first.encrypt(iv, plainText, sizeof(plainText));
+
+    TEST_ASSERT_EQUAL_MEMORY(aes128CipherText, firstBlock.data(), 16);
+    TEST_ASSERT_EQUAL_MEMORY(aes128CipherText, firstMessage.data(), sizeof(aes128CipherText));
+    TEST_ASSERT_FALSE(memcmp(firstBlock.data(), secondBlock.data(), 16) == 0);
+    TEST_ASSERT_EQUAL_MEMORY(secondBlock.data(), CryptoHelper::aesCbc128Encrypt(aes256Key, iv, plainText, 16).data(), 16);
+}
+
+void testAes256Cbc() {
+    Buffer encrypted = CryptoHelper::aesCbc256Encrypt(aes256Key, iv, plainText, sizeof(plainText));
+    TEST_ASSERT_EQUAL_MEMORY(aes256CipherText, encrypted.data(), sizeof(aes256CipherText));
+
+    Buffer decrypted = CryptoHelper::aesCbc256Decrypt(aes256Key, iv, aes256CipherText, sizeof(aes256CipherText));
+    TEST_ASSERT_EQUAL_MEMORY(plainText, decrypted.data(), sizeof(plainText));
+}
+
+void testMd5() {
+    // RFC 1321, appendix A.5
+    const uint8_t emptyDigest[16] = {0xd4, 0x1d, 0x8c, 0xd9, 0x8f, 0x00, 0xb2, 0x04, 0xe9, 0x80, 0x09, 0x98, 0xec, 0xf8, 0x42, 0x7e};
+    const uint8_t abcDigest[16] = {0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0, 0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72};
+    const uint8_t messageDigestDigest[16] = {0xf9, 0x6b, 0x69, 0x7d, 0x7c, 0xb7, 0x93, 0x8d, 0x52, 0x5a, 0x2f, 0x31, 0xaa, 0xf1, 0x61, 0xd0};
+
+    TEST_ASSERT_EQUAL_MEMORY(emptyDigest, CryptoHelper::md5(nullptr, 0).data(), 16);
+    TEST_ASSERT_EQUAL_MEMORY(abcDigest, CryptoHelper::md5(reinterpret_cast<const uint8_t*>("abc"), 3).data(), 16);
+    TEST_ASSERT_EQUAL_MEMORY(messageDigestDigest, CryptoHelper::md5(reinterpret_cast<const uint8_t*>("message digest"), 14).data(), 16);
+}
+
+void benchmarkBackend() {
+    TEST_MESSAGE(CryptoBackend::name());
+
+    // the encrypted part of a small datapoint message and of a large one
+    static uint8_t data[512];
+    AesCbc128Key key(aes128Key);
+    for(size_t length : {size_t(48), sizeof(data)}) {
+        char name[80];
+
+        snprintf(name, sizeof(name), "aes-128-cbc encrypt, %u bytes", static_cast<unsigned>(length));
+        benchmark(name, 500, [&]() { key.encryptInPlace(iv, data, length); });
+
+        snprintf(name, sizeof(name), "aes-128-cbc decrypt, %u bytes", static_cast<unsigned>(length));
+        benchmark(name, 500, [&]() { key.decryptInPlace(iv, data, length); });
+    }
+
+    // deriving the local key and the session key
+    benchmark("md5, 16 bytes", 500, []() { CryptoHelper::md5(aes128Key, sizeof(aes128Key)); });
+}
+
+void benchmarkKeySchedule() {
+    // a datapoint message: expanding the key for every message, like before, or once per session
+    static uint8_t data[48];
+    benchmark("encrypt a message, key expanded per message", 1000, []() {
+        CryptoHelper::aesCbc128EncryptInPlace(aes128Key, iv, data, sizeof(data));
+    });
+
+    AesCbc128Key key(aes128Key);
+    benchmark("encrypt a message, key expanded per session", 1000, [&key]() {
+        key.encryptInPlace(iv, data, sizeof(data));
+    });
+
+    benchmark("decrypt a message, key expanded per message", 1000, []() {
+        CryptoHelper::aesCbc128DecryptInPlace(aes128Key, iv, data, sizeof(data));
+    });
+
+    benchmark("decrypt a message, key expanded per session", 1000, [&key]() {
+        key.decryptInPlace(iv, data, sizeof(data));
+    });
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testAes128Cbc);
+    RUN_TEST(testAes128CbcInPlace);
+    RUN_TEST(testKeysDontShareState);
+    RUN_TEST(testAes256Cbc);
+    RUN_TEST(testMd5);
+    RUN_TEST(benchmarkBackend);
+    RUN_TEST(benchmarkKeySchedule);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
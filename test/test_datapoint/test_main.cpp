@@ -0,0 +1,156 @@
+#include "../TestSupport.h"
+
+#include <utility>
+#include <vector>
+
+#include "Buffer.h"
+#include "BufferView.h"
+#include "TuyaDataPoint.h"
+
+static const uint8_t shortPayload[] = {1, 2, 3, 4, 5, 6};
+static const uint8_t longPayload[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+
+static bool isPayloadInline(const TuyaDataPoint& dataPoint) {
+    return isInside(dataPoint, dataPoint.payload().data());
+}
+
+void testSize() {
+    // dp, type and payload size, then the inline payload, which also holds the scalar or heap pointer, and padding
+    TEST_ASSERT_LESS_OR_EQUAL(4 + TuyaDataPoint::inlinePayloadCapacity + sizeof(void*), sizeof(TuyaDataPoint));
+
+    char message[64];
+    snprintf(message, sizeof(message), "sizeof(TuyaDataPoint) = %u", static_cast<unsigned>(sizeof(TuyaDataPoint)));
+    TEST_MESSAGE(message);
+}
+
+void testScalars() {
+    TuyaDataPoint boolean = TuyaDataPoint::boolean(1, true);
+    TEST_ASSERT_EQUAL(TuyaDataPointType::boolean, boolean.type());
+    // booleans are stored inverted, like they were in 1.0
+    TEST_ASSERT_FALSE(boolean.boolean());
+    TEST_ASSERT_TRUE(TuyaDataPoint::boolean(1, false).boolean());
+    TEST_ASSERT_EQUAL(0, boolean.payload().size());
+
+    TuyaDataPoint value = TuyaDataPoint::value(2, -123456);
+    TEST_ASSERT_EQUAL(TuyaDataPointType::value, value.type());
+    TEST_ASSERT_EQUAL_INT32(-123456, value.value());
+
+    TuyaDataPoint enumeration = TuyaDataPoint::enumeration(3, 7);
+    TEST_ASSERT_EQUAL(TuyaDataPointType::enumeration, enumeration.type());
+    TEST_ASSERT_EQUAL_UINT8(7, enumeration.enumeration());
+}
+
+void testPayloads() {
+    TuyaDataPoint small = TuyaDataPoint::raw(1, BufferView(shortPayload, sizeof(shortPayload)));
+    TEST_ASSERT_TRUE(isPayloadInline(small));
+    TEST_ASSERT_EQUAL(sizeof(shortPayload), small.raw().size());
+    TEST_ASSERT_EQUAL_MEMORY(shortPayload, small.raw().data(), sizeof(shortPayload));
+
+    TuyaDataPoint large = TuyaDataPoint::bitmap(2, BufferView(longPayload, sizeof(longPayload)));
+    TEST_ASSERT_FALSE(isPayloadInline(large));
+    TEST_ASSERT_EQUAL(sizeof(longPayload), large.bitmap().size());
+    TEST_ASSERT_EQUAL_MEMORY(longPayload, large.bitmap().data(), sizeof(longPayload));
+
+    TuyaDataPoint string = TuyaDataPoint::string(3, String("hello"));
+    TEST_ASSERT_TRUE(isPayloadInline(string));
+    TEST_ASSERT_TRUE(string.string() == String("hello"));
+}
+
+void testCopyAndMove() {
+    TuyaDataPoint large = TuyaDataPoint::raw(1, BufferView(longPayload, sizeof(longPayload)));
+
+    TuyaDataPoint copy = large;
+    TEST_ASSERT_TRUE(copy == large);
+    TEST_ASSERT_TRUE(copy.payload().data() != large.payload().data());
+
+    // moving takes the heap payload over
+    const uint8_t* payload = large.payload().data();
+    TuyaDataPoint moved = std::move(large);
+    TEST_ASSERT_TRUE(moved.payload().data() == payload);
+    TEST_ASSERT_TRUE(moved == copy);
+
+    // assigning another type releases the payload
+    moved = TuyaDataPoint::value(1, 5);
+    TEST_ASSERT_EQUAL(TuyaDataPointType::value, moved.type());
+    TEST_ASSERT_EQUAL(0, moved.payload().size());
+
+    // setting a payload from its own bytes
+    copy.setRaw(copy.raw().subRangeWithStartAndLength(2, 4));
+    TEST_ASSERT_EQUAL(4, copy.raw().size());
+    TEST_ASSERT_EQUAL_MEMORY(longPayload + 2, copy.raw().data(), 4);
+}
+
+void testEquality() {
+    TEST_ASSERT_TRUE(TuyaDataPoint::value(1, 5) == TuyaDataPoint::value(1, 5));
+    TEST_ASSERT_TRUE(TuyaDataPoint::value(1, 5) != TuyaDataPoint::value(1, 6));
+    TEST_ASSERT_TRUE(TuyaDataPoint::value(1, 5) != TuyaDataPoint::value(2, 5));
+    TEST_ASSERT_TRUE(TuyaDataPoint::value(1, 1) != TuyaDataPoint::boolean(1, true));
+    TEST_ASSERT_TRUE(TuyaDataPoint::raw(1, BufferView(shortPayload, 3)) != TuyaDataPoint::raw(1, BufferView(shortPayload, 4)));
+}
+
+void testEncoding() {
+    // id, type, 1 byte length, value
+    Buffer value;
+    TuyaDataPoint::value(2, -2).encode(value, 1);
+    const uint8_t expectedValue[] = {2, 2, 4, 0xFF, 0xFF, 0xFF, 0xFE};
+    TEST_ASSERT_EQUAL(sizeof(expectedValue), value.size());
+    TEST_ASSERT_EQUAL_MEMORY(expectedValue, value.data(), sizeof(expectedValue));
+
+    Buffer enumeration;
+    TuyaDataPoint::enumeration(3, 7).encode(enumeration, 1);
+    const uint8_t expectedEnumeration[] = {3, 4, 4, 0, 0, 0, 7};
+    TEST_ASSERT_EQUAL(sizeof(expectedEnumeration), enumeration.size());
+    TEST_ASSERT_EQUAL_MEMORY(expectedEnumeration, enumeration.data(), sizeof(expectedEnumeration));
+
+    Buffer boolean;
+    TuyaDataPoint::boolean(1, true).encode(boolean, 1);
+    const uint8_t expectedBoolean[] = {1, 1, 1, 0};
+    TEST_ASSERT_EQUAL(sizeof(expectedBoolean), boolean.size());
+    TEST_ASSERT_EQUAL_MEMORY(expectedBoolean, boolean.data(), sizeof(expectedBoolean));
+
+    // the v4 messages have 2 byte lengths
+    Buffer raw;
+    TuyaDataPoint::raw(71, BufferView(shortPayload, sizeof(shortPayload))).encode(raw, 2);
+    const uint8_t expectedRaw[] = {71, 0, 0, 6, 1, 2, 3, 4, 5, 6};
+    TEST_ASSERT_EQUAL(sizeof(expectedRaw), raw.size());
+    TEST_ASSERT_EQUAL_MEMORY(expectedRaw, raw.data(), sizeof(expectedRaw));
+
+    Buffer v4Value;
+    TuyaDataPoint::value(2, 0x01020304).encode(v4Value, 2);
+    const uint8_t expectedV4Value[] = {2, 2, 0, 4, 1, 2, 3, 4};
+    TEST_ASSERT_EQUAL(sizeof(expectedV4Value), v4Value.size());
+    TEST_ASSERT_EQUAL_MEMORY(expectedV4Value, v4Value.data(), sizeof(expectedV4Value));
+}
+
+void benchmarkDataPoints() {
+    BufferView shortView(shortPayload, sizeof(shortPayload));
+    BufferView longView(longPayload, sizeof(longPayload));
+
+    // what decoding a received datapoint of each type does
+    benchmark("decode boolean", 10000, []() { TuyaDataPoint::boolean(1, true); });
+    benchmark("decode value", 10000, []() { TuyaDataPoint::value(1, 42); });
+    benchmark("decode enumeration", 10000, []() { TuyaDataPoint::enumeration(1, 2); });
+    benchmark("decode 6 byte raw", 10000, [&shortView]() { TuyaDataPoint::raw(1, shortView); });
+    benchmark("decode 20 byte raw", 10000, [&longView]() { TuyaDataPoint::raw(1, longView); });
+    benchmark("decode 6 byte string", 10000, [&shortView]() { TuyaDataPoint dataPoint(1, TuyaDataPointType::string); dataPoint.setString(shortView); });
+
+    std::vector<TuyaDataPoint> dataPoints;
+    for(uint8_t dp = 1; dp <= 100; dp++) {
+        dataPoints.push_back(dp % 3 == 0 ? TuyaDataPoint::raw(dp, shortView) : TuyaDataPoint::value(dp, dp));
+    }
+    benchmark("copy 100 datapoints", 1000, [&dataPoints]() { std::vector<TuyaDataPoint> copy = dataPoints; });
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testSize);
+    RUN_TEST(testScalars);
+    RUN_TEST(testPayloads);
+    RUN_TEST(testCopyAndMove);
+    RUN_TEST(testEquality);
+    RUN_TEST(testEncoding);
+    RUN_TEST(benchmarkDataPoints);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
@@ -0,0 +1,167 @@
+#include "../TestSupport.h"
+
+#include "Buffer.h"
+#include "BufferArena.h"
+#include "BufferView.h"
+#include "ByteReader.h"
+#include "Crc16.h"
+#include "TuyaBLEDataPointReport.h"
+#include "TuyaBLEReceivedMessage.h"
+#include "TuyaDataPoint.h"
+
+// decrypted frames as a v3 device sends them: sequence number, response to, function code, length, data, crc
+
+// receiveSignDp, sn 300, mode 0: dp 47 (bool) = true, dp 9 (enum) = 2
+static const uint8_t signedReport[] = {
+    0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x80, 0x04, 0x00, 0x0B,
+    0x01, 0x2C, 0x00,
+    0x2F, 0x01, 0x01, 0x01,
+    0x09, 0x04, 0x01, 0x02,
+    0xFD, 0x8F,
+};
+
+// receiveSignTimeDp, sn 301, mode 0, 1700000000 seconds: dp 12 (raw) = 01 02 03
+static const uint8_t signedTimestampedReport[] = {
+    0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x00, 0x80, 0x05, 0x00, 0x0E,
+    0x01, 0x2D, 0x00,
+    0x01, 0x65, 0x53, 0xF1, 0x00,
+    0x0C, 0x00, 0x03, 0x01, 0x02, 0x03,
+    0x3D, 0x30,
+};
+
+// receiveSignTimeDp, sn 302, mode 1, "1700000000123" milliseconds: dp 47 (bool) = false
+static const uint8_t signedMillisecondsReport[] = {
+    0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x80, 0x05, 0x00, 0x15,
+    0x01, 0x2E, 0x01,
+    0x00, 0x31, 0x37, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0x31, 0x32, 0x33,
+    0x2F, 0x01, 0x01, 0x00,
+    0x5B, 0x54,
+};
+
+/// parses a decrypted frame the way `TuyaBLEDevice` does
+static TuyaBLEReceivedMessage parseFrame(const uint8_t* bytes, size_t length) {
+    ByteReader reader(BufferView(bytes, length));
+    TuyaBLEReceivedMessage message;
+    message.sequenceNumber = reader.readBigEndianUint32();
+    message.responseToSequenceNumber = reader.readBigEndianUint32();
+    message.functionCode = static_cast<TuyaBLEFunctionCode>(reader.readBigEndianUint16());
+    message.data = reader.readBuffer(reader.readBigEndianUint16());
+    size_t checkedLength = reader.offset();
+    uint16_t crc = reader.readBigEndianUint16();
+    TEST_ASSERT_TRUE(reader.isValid());
+    TEST_ASSERT_EQUAL_HEX16(Crc16::compute(bytes, checkedLength), crc);
+    return message;
+}
+
+static void assertAcknowledgement(const TuyaBLEDataPointReport& report, const uint8_t* expected, size_t length) {
+    Buffer acknowledgement;
+    report.appendAcknowledgement(acknowledgement);
+    TEST_ASSERT_EQUAL(length, acknowledgement.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, acknowledgement.data(), length);
+}
+
+void testSignedReport() {
+    TuyaBLEReceivedMessage message = parseFrame(signedReport, sizeof(signedReport));
+    TEST_ASSERT_TRUE(message.functionCode == TuyaBLEFunctionCode::receiveSignDp);
+
+    TuyaBLEDataPointReport report;
+    TEST_ASSERT_TRUE(report.parse(message));
+    TEST_ASSERT_FALSE(report.hasTimestamp);
+
+    // the header is a 16 bit sequence number and the mode, so the first datapoint starts right after it
+    BufferArena arena(256);
+    TuyaBLEReceivedDataPointItems items{BufferArenaAllocator<TuyaBLEReceivedDataPointItem>(&arena)};
+    TEST_ASSERT_TRUE(report.parseItems(items));
+    TEST_ASSERT_EQUAL(2, items.size());
+    TEST_ASSERT_TRUE(items[0].toDataPoint() == TuyaDataPoint::boolean(47, true));
+    TEST_ASSERT_TRUE(items[1].toDataPoint() == TuyaDataPoint::enumeration(9, 2));
+
+    // acknowledged with the sequence number, the mode and a status of 0
+    TEST_ASSERT_TRUE(report.wantsAcknowledgement);
+    const uint8_t acknowledgement[] = {0x01, 0x2C, 0x00, 0x00};
+    assertAcknowledgement(report, acknowledgement, sizeof(acknowledgement));
+}
+
+void testSignedTimestampedReport() {
+    TuyaBLEDataPointReport report;
+    TEST_ASSERT_TRUE(report.parse(parseFrame(signedTimestampedReport, sizeof(signedTimestampedReport))));
+    TEST_ASSERT_TRUE(report.hasTimestamp);
+    TEST_ASSERT_TRUE(report.timestampMs == 1700000000000ULL);
+
+    BufferArena arena(256);
+    TuyaBLEReceivedDataPointItems items{BufferArenaAllocator<TuyaBLEReceivedDataPointItem>(&arena)};
+    TEST_ASSERT_TRUE(report.parseItems(items));
+    TEST_ASSERT_EQUAL(1, items.size());
+    const uint8_t payload[] = {0x01, 0x02, 0x03};
+    TEST_ASSERT_TRUE(items[0].toDataPoint() == TuyaDataPoint::raw(12, BufferView(payload, sizeof(payload))));
+
+    const uint8_t acknowledgement[] = {0x01, 0x2D, 0x00, 0x00};
+    assertAcknowledgement(report, acknowledgement, sizeof(acknowledgement));
+
+    TEST_ASSERT_TRUE(report.parse(parseFrame(signedMillisecondsReport, sizeof(signedMillisecondsReport))));
+    TEST_ASSERT_TRUE(report.timestampMs == 1700000000123ULL);
+    items.clear();
+    TEST_ASSERT_TRUE(report.parseItems(items));
+    TEST_ASSERT_TRUE(items[0].toDataPoint() == TuyaDataPoint::boolean(47, false));
+
+    const uint8_t millisecondsAcknowledgement[] = {0x01, 0x2E, 0x01, 0x00};
+    assertAcknowledgement(report, millisecondsAcknowledgement, sizeof(millisecondsAcknowledgement));
+}
+
+void testOtherReports() {
+    const uint8_t dataPoints[] = {0x2F, 0x01, 0x01, 0x01};
+    TuyaBLEReceivedMessage message;
+    message.data = BufferView(dataPoints, sizeof(dataPoints));
+
+    // plain reports aren't acknowledged
+    TuyaBLEDataPointReport report;
+    message.functionCode = TuyaBLEFunctionCode::receiveDp;
+    TEST_ASSERT_TRUE(report.parse(message));
+    TEST_ASSERT_FALSE(report.wantsAcknowledgement);
+    TEST_ASSERT_EQUAL(sizeof(dataPoints), report.dataPoints.size());
+
+    // v4 reports have a 32 bit sequence number, the report type and an acknowledgement flag
+    const uint8_t v4Report[] = {0x00, 0x00, 0x01, 0x2C, 0x01, 0x00, 0x00, 0x2F, 0x01, 0x00, 0x01, 0x01};
+    message.functionCode = TuyaBLEFunctionCode::receiveDpV4;
+    message.data = BufferView(v4Report, sizeof(v4Report));
+    TEST_ASSERT_TRUE(report.parse(message));
+    TEST_ASSERT_EQUAL(2, report.numberOfLengthBytes);
+    TEST_ASSERT_TRUE(report.wantsAcknowledgement);
+    const uint8_t v4Acknowledgement[] = {0x00, 0x00, 0x01, 0x2C, 0x01, 0x00, 0x00};
+    assertAcknowledgement(report, v4Acknowledgement, sizeof(v4Acknowledgement));
+
+    const uint8_t v4ReportWithoutAcknowledgement[] = {0x00, 0x00, 0x01, 0x2C, 0x01, 0x00, 0x01};
+    message.data = BufferView(v4ReportWithoutAcknowledgement, sizeof(v4ReportWithoutAcknowledgement));
+    TEST_ASSERT_TRUE(report.parse(message));
+    TEST_ASSERT_FALSE(report.wantsAcknowledgement);
+
+    // and other messages aren't reports
+    message.functionCode = TuyaBLEFunctionCode::receiveTime1Req;
+    TEST_ASSERT_FALSE(report.parse(message));
+}
+
+void testMalformedReports() {
+    TuyaBLEReceivedMessage message;
+    TuyaBLEDataPointReport report;
+
+    const uint8_t shortHeader[] = {0x01, 0x2C};
+    message.functionCode = TuyaBLEFunctionCode::receiveSignDp;
+    message.data = BufferView(shortHeader, sizeof(shortHeader));
+    TEST_ASSERT_FALSE(report.parse(message));
+
+    const uint8_t invalidDigits[] = {0x01, 0x2C, 0x00, 0x00, '1', '7', 'x', '0', '0', '0', '0', '0', '0', '0', '0', '0', '0'};
+    message.functionCode = TuyaBLEFunctionCode::receiveSignTimeDp;
+    message.data = BufferView(invalidDigits, sizeof(invalidDigits));
+    TEST_ASSERT_FALSE(report.parse(message));
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testSignedReport);
+    RUN_TEST(testSignedTimestampedReport);
+    RUN_TEST(testOtherReports);
+    RUN_TEST(testMalformedReports);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
@@ -0,0 +1,127 @@
+#include "../TestSupport.h"
+
+#include <vector>
+
+#include "Buffer.h"
+#include "Crc16.h"
+#include "CryptoHelper.h"
+#include "TuyaBLEFrameEncoder.h"
+
+static const uint8_t keyBytes[16] = {0x00, 0x07, 0x0E, 0x15, 0x1C, 0x23, 0x2A, 0x31, 0x38, 0x3F, 0x46, 0x4D, 0x54, 0x5B, 0x62, 0x69};
+static const uint8_t iv[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+static const uint8_t protocolVersion = 3;
+
+/// the encoder this replaced: createMessage() followed by splitIntoPackets(), with a buffer per step and per packet
+static std::vector<Buffer> encodeWithPreviousEncoder(TuyaBLESecurityFlag securityFlag, uint32_t sequenceNumber, uint32_t responseTo,
+    TuyaBLEFunctionCode code, const Buffer& data, size_t maximumPacketLength) {
+    Buffer messageData;
+    messageData.appendBigEndian(sequenceNumber);
+    messageData.appendBigEndian(responseTo);
+    messageData.appendBigEndian(static_cast<uint16_t>(code));
+    messageData.appendBigEndian(static_cast<uint16_t>(data.size()));
+    messageData.append(data);
+    messageData.appendBigEndian(Crc16::computeBitwise(messageData.data(), messageData.size()));
+    messageData.padToNumberOfBytes(16);
+
+    Buffer message;
+    message.append(static_cast<uint8_t>(securityFlag));
+    message.append(iv, sizeof(iv));
+    message.append(CryptoHelper::aesCbc128Encrypt(keyBytes, iv, messageData.data(), messageData.size()));
+
+    std::vector<Buffer> packets;
+    size_t position = 0;
+    unsigned int packetNumber = 0;
+    while(position < message.size()) {
+        Buffer packet;
+        packet.appendPackedInt(packetNumber);
+        if(packetNumber == 0) {
+            packet.appendPackedInt(message.size());
+            packet.append(static_cast<uint8_t>(protocolVersion << 4));
+        }
+
+        size_t dataLength = std::min(maximumPacketLength - packet.size(), message.size() - position);
+        packet.append(message, position, dataLength);
+        packets.push_back(packet);
+
+        packetNumber++;
+        position += dataLength;
+    }
+    return packets;
+}
+
+static Buffer makeData(size_t length) {
+    Buffer data;
+    for(size_t index = 0; index < length; index++) data.append(static_cast<uint8_t>(index * 31 + length));
+    return data;
+}
+
+void testMatchesPreviousEncoder() {
+    AesCbc128Key key(keyBytes);
+    TuyaBLEEncodedFrame frame;
+
+    // the default GATT packet, small and large negotiated MTUs; every data length around the
+    // packet and block boundaries, and up to the length of long (v4) datapoint messages
+    for(size_t maximumPacketLength : {20, 23, 100, 185, 244}) {
+        for(size_t length = 0; length < 2100; length += (length < 100 ? 1 : 37)) {
+            Buffer data = makeData(length);
+            uint32_t sequenceNumber = 42 + length;
+            std::vector<Buffer> expected = encodeWithPreviousEncoder(TuyaBLESecurityFlag::sessionKey, sequenceNumber, 7,
+                TuyaBLEFunctionCode::senderDps, data, maximumPacketLength);
+            TuyaBLEFrameEncoder::encode(frame, TuyaBLESecurityFlag::sessionKey, key, iv, sequenceNumber, 7,
+                TuyaBLEFunctionCode::senderDps, data, protocolVersion, maximumPacketLength);
+
+            TEST_ASSERT_EQUAL(expected.size(), frame.numberOfPackets());
+            for(size_t index = 0; index < expected.size(); index++) {
+                BufferView packet = frame.packet(index);
+                TEST_ASSERT_LESS_OR_EQUAL(maximumPacketLength, packet.size());
+                TEST_ASSERT_EQUAL(expected[index].size(), packet.size());
+                TEST_ASSERT_EQUAL_MEMORY(expected[index].data(), packet.data(), packet.size());
+            }
+        }
+    }
+}
+
+void testReusedFrameDoesntReallocate() {
+    AesCbc128Key key(keyBytes);
+    TuyaBLEEncodedFrame frame;
+    Buffer data = makeData(200);
+
+    TuyaBLEFrameEncoder::encode(frame, TuyaBLESecurityFlag::sessionKey, key, iv, 1, 0, TuyaBLEFunctionCode::senderDps, data, protocolVersion, 20);
+    const uint8_t* storage = frame.bytes().data();
+    for(uint32_t sequenceNumber = 2; sequenceNumber < 10; sequenceNumber++) {
+        frame.clear();
+        TuyaBLEFrameEncoder::encode(frame, TuyaBLESecurityFlag::sessionKey, key, iv, sequenceNumber, 0, TuyaBLEFunctionCode::senderDps, data, protocolVersion, 20);
+        TEST_ASSERT_TRUE(frame.bytes().data() == storage);
+    }
+}
+
+void benchmarkEncoders() {
+    AesCbc128Key key(keyBytes);
+    TuyaBLEEncodedFrame frame;
+
+    for(size_t length : {size_t(8), size_t(64), size_t(512)}) {
+        Buffer data = makeData(length);
+        char name[80];
+
+        snprintf(name, sizeof(name), "previous encoder, %u data bytes, per message", static_cast<unsigned>(length));
+        benchmark(name, 500, [&]() {
+            encodeWithPreviousEncoder(TuyaBLESecurityFlag::sessionKey, 1, 0, TuyaBLEFunctionCode::senderDps, data, 20);
+        });
+
+        snprintf(name, sizeof(name), "frame encoder, %u data bytes, per message", static_cast<unsigned>(length));
+        benchmark(name, 500, [&]() {
+            frame.clear();
+            TuyaBLEFrameEncoder::encode(frame, TuyaBLESecurityFlag::sessionKey, key, iv, 1, 0, TuyaBLEFunctionCode::senderDps, data, protocolVersion, 20);
+        });
+    }
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testMatchesPreviousEncoder);
+    RUN_TEST(testReusedFrameDoesntReallocate);
+    RUN_TEST(benchmarkEncoders);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
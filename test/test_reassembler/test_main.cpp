@@ -0,0 +1,80 @@
+#include "../TestSupport.h"
+
+#include "Buffer.h"
+#include "TuyaBLEDeviceStatistics.h"
+#include "TuyaBLEMessageReassembler.h"
+
+/// packet 0 of a `messageLength` byte message, with `dataLength` bytes of it
+static Buffer firstPacket(uint32_t messageLength, size_t dataLength) {
+    Buffer packet;
+    packet.appendPackedInt(0);
+    packet.appendPackedInt(messageLength);
+    packet.append(static_cast<uint8_t>(3 << 4));
+    packet.appendRepeated(0xA0, dataLength);
+    return packet;
+}
+
+static Buffer nextPacket(uint32_t packetNumber, size_t dataLength) {
+    Buffer packet;
+    packet.appendPackedInt(packetNumber);
+    packet.appendRepeated(static_cast<uint8_t>(0xA0 + packetNumber), dataLength);
+    return packet;
+}
+
+void testReassemblesPackets() {
+    TuyaBLEMessageReassembler reassembler;
+    TuyaBLEDeviceStatistics statistics;
+
+    TEST_ASSERT_TRUE(reassembler.addPacket(firstPacket(40, 17), 0, statistics) == TuyaBLEMessageReassembler::Result::incomplete);
+    TEST_ASSERT_TRUE(reassembler.addPacket(nextPacket(1, 19), 10, statistics) == TuyaBLEMessageReassembler::Result::incomplete);
+    TEST_ASSERT_TRUE(reassembler.addPacket(nextPacket(1, 19), 20, statistics) == TuyaBLEMessageReassembler::Result::ignored);
+    TEST_ASSERT_TRUE(reassembler.addPacket(nextPacket(2, 4), 30, statistics) == TuyaBLEMessageReassembler::Result::complete);
+
+    TEST_ASSERT_EQUAL(40, reassembler.message().size());
+    TEST_ASSERT_EQUAL_UINT8(0xA2, reassembler.message()[39]);
+    TEST_ASSERT_EQUAL(1, statistics.duplicatePackets);
+    TEST_ASSERT_FALSE(reassembler.isInProgress());
+}
+
+void testStaleMessageExpiresWithoutAnotherPacket() {
+    TuyaBLEMessageReassembler reassembler;
+    TuyaBLEDeviceStatistics statistics;
+    reassembler.setTimeout(100);
+
+    reassembler.addPacket(firstPacket(40, 17), 1000, statistics);
+    reassembler.expireStaleMessage(1100, statistics);
+    TEST_ASSERT_TRUE(reassembler.isInProgress());
+
+    reassembler.expireStaleMessage(1101, statistics);
+    TEST_ASSERT_FALSE(reassembler.isInProgress());
+    TEST_ASSERT_EQUAL(1, statistics.timedOutMessages);
+    TEST_ASSERT_EQUAL(1, statistics.abandonedMessages);
+
+    // the rest of the expired message is dropped
+    TEST_ASSERT_TRUE(reassembler.addPacket(nextPacket(1, 19), 1102, statistics) == TuyaBLEMessageReassembler::Result::ignored);
+
+    // expiring again doesn't count it twice
+    reassembler.expireStaleMessage(5000, statistics);
+    TEST_ASSERT_EQUAL(1, statistics.timedOutMessages);
+}
+
+void testCompletedMessageDoesntExpire() {
+    TuyaBLEMessageReassembler reassembler;
+    TuyaBLEDeviceStatistics statistics;
+    reassembler.setTimeout(100);
+
+    TEST_ASSERT_TRUE(reassembler.addPacket(firstPacket(10, 10), 0, statistics) == TuyaBLEMessageReassembler::Result::complete);
+    reassembler.expireStaleMessage(1000, statistics);
+    TEST_ASSERT_EQUAL(0, statistics.timedOutMessages);
+    TEST_ASSERT_EQUAL(10, reassembler.message().size());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testReassemblesPackets);
+    RUN_TEST(testStaleMessageExpiresWithoutAnotherPacket);
+    RUN_TEST(testCompletedMessageDoesntExpire);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
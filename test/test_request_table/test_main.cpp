@@ -0,0 +1,160 @@
+#include "../TestSupport.h"
+
+#include "TuyaBLEReceivedMessage.h"
+#include "TuyaBLERequestTable.h"
+
+typedef TuyaBLERequestTable::Request Request;
+
+static Request makeRequest(TuyaBLERequestTable::ResponseHandler handler) {
+    Request request;
+    request.code = TuyaBLEFunctionCode::senderDps;
+    request.timeoutMs = 1000;
+    request.handler = handler;
+    return request;
+}
+
+void testHandlersGetTheStatusCallbacksOfTheirRequest() {
+    TuyaBLERequestTable requests;
+    size_t numberOfCalls = 0;
+    TuyaBLERequestStatus lastStatus = TuyaBLERequestStatus::failed;
+
+    // the handler only captures what it needs, the callbacks travel with the request
+    Request request = makeRequest([](TuyaBLERequestStatus status, const TuyaBLEReceivedMessage* response, const Request& completedRequest) {
+        TEST_ASSERT_TRUE(status == TuyaBLERequestStatus::success);
+        TEST_ASSERT_TRUE(response != nullptr);
+        for(auto&& callback : completedRequest.statusCallbacks)
+            callback(nullptr, status);
+    });
+    for(size_t index = 0; index < 2; index++) {
+        request.statusCallbacks.push_back([&](TuyaBLEDevice*, TuyaBLERequestStatus status) {
+            numberOfCalls += 1;
+            lastStatus = status;
+        });
+    }
+    request.sequenceNumber = 5;
+    TEST_ASSERT_TRUE(requests.add(request, 0));
+    TEST_ASSERT_TRUE(request.statusCallbacks.empty());
+
+    TuyaBLEReceivedMessage response;
+    TEST_ASSERT_FALSE(requests.complete(response, 4));
+    TEST_ASSERT_TRUE(requests.complete(response, 5));
+    TEST_ASSERT_EQUAL(2, numberOfCalls);
+    TEST_ASSERT_TRUE(lastStatus == TuyaBLERequestStatus::success);
+    TEST_ASSERT_TRUE(requests.isEmpty());
+}
+
+void testFailedRequestsCallTheirHandlers() {
+    TuyaBLERequestTable requests;
+    size_t numberOfTimeouts = 0;
+    size_t numberOfDisconnects = 0;
+    TuyaBLERequestTable::ResponseHandler handler = [&](TuyaBLERequestStatus status, const TuyaBLEReceivedMessage* response, const Request&) {
+        TEST_ASSERT_TRUE(response == nullptr);
+        if(status == TuyaBLERequestStatus::timeout) numberOfTimeouts += 1;
+        if(status == TuyaBLERequestStatus::disconnected) numberOfDisconnects += 1;
+    };
+
+    for(uint32_t sequenceNumber = 1; sequenceNumber <= 3; sequenceNumber++) {
+        Request request = makeRequest(handler);
+        request.sequenceNumber = sequenceNumber;
+        TEST_ASSERT_TRUE(requests.add(request, 0));
+    }
+
+    TEST_ASSERT_TRUE(requests.fail(2, TuyaBLERequestStatus::timeout));
+    TEST_ASSERT_FALSE(requests.fail(2, TuyaBLERequestStatus::timeout));
+    requests.failAll(TuyaBLERequestStatus::disconnected);
+    TEST_ASSERT_EQUAL(1, numberOfTimeouts);
+    TEST_ASSERT_EQUAL(2, numberOfDisconnects);
+    TEST_ASSERT_TRUE(requests.isEmpty());
+}
+
+void testRequestsThatOnlyWaitToBeSent() {
+    TuyaBLERequestTable requests;
+    size_t numberOfSentCalls = 0;
+
+    Request request;
+    request.sequenceNumber = 7;
+    request.onSent = [&](TuyaBLEDevice*, bool success) {
+        TEST_ASSERT_TRUE(success);
+        numberOfSentCalls += 1;
+    };
+    TEST_ASSERT_TRUE(requests.add(request, 0));
+    TEST_ASSERT_TRUE(requests.hasSentHandler(7));
+
+    // it has no deadline and no response completes it
+    Request expired;
+    TEST_ASSERT_FALSE(requests.takeExpired(10000, expired));
+    TuyaBLEReceivedMessage response;
+    TEST_ASSERT_FALSE(requests.complete(response, 7));
+
+    // once it's sent, it's done
+    TuyaBLERequestTable::SentHandler onSent;
+    TEST_ASSERT_TRUE(requests.takeSentHandler(7, onSent));
+    onSent(nullptr, true);
+    TEST_ASSERT_EQUAL(1, numberOfSentCalls);
+    TEST_ASSERT_TRUE(requests.isEmpty());
+    TEST_ASSERT_FALSE(requests.takeSentHandler(7, onSent));
+}
+
+void testSentRequestsKeepWaitingForTheirResponse() {
+    TuyaBLERequestTable requests;
+    bool hasResponse = false;
+
+    Request request = makeRequest([&](TuyaBLERequestStatus status, const TuyaBLEReceivedMessage*, const Request&) {
+        hasResponse = status == TuyaBLERequestStatus::success;
+    });
+    request.sequenceNumber = 9;
+    request.onSent = [](TuyaBLEDevice*, bool) {};
+    TEST_ASSERT_TRUE(requests.add(request, 0));
+
+    TuyaBLERequestTable::SentHandler onSent;
+    TEST_ASSERT_TRUE(requests.takeSentHandler(9, onSent));
+    TEST_ASSERT_FALSE(requests.hasSentHandler(9));
+    TEST_ASSERT_TRUE(requests.contains(9));
+
+    TuyaBLEReceivedMessage response;
+    TEST_ASSERT_TRUE(requests.complete(response, 9));
+    TEST_ASSERT_TRUE(hasResponse);
+}
+
+void testExpiredRequests() {
+    TuyaBLERequestTable requests;
+    Request request = makeRequest([](TuyaBLERequestStatus, const TuyaBLEReceivedMessage*, const Request&) {});
+    request.sequenceNumber = 3;
+    TEST_ASSERT_TRUE(requests.add(request, 0));
+
+    Request expired;
+    TEST_ASSERT_FALSE(requests.takeExpired(500, expired));
+    TEST_ASSERT_TRUE(requests.takeExpired(1100, expired));
+    TEST_ASSERT_EQUAL(3, expired.sequenceNumber);
+    TEST_ASSERT_TRUE(requests.isEmpty());
+}
+
+void testFullTable() {
+    TuyaBLERequestTable requests;
+    for(uint32_t sequenceNumber = 1; sequenceNumber <= TuyaBLERequestTable::capacity; sequenceNumber++) {
+        Request request = makeRequest([](TuyaBLERequestStatus, const TuyaBLEReceivedMessage*, const Request&) {});
+        request.sequenceNumber = sequenceNumber;
+        TEST_ASSERT_TRUE(requests.add(request, 0));
+    }
+    TEST_ASSERT_TRUE(requests.isFull());
+
+    // a request that isn't added stays with the caller
+    Request request = makeRequest([](TuyaBLERequestStatus, const TuyaBLEReceivedMessage*, const Request&) {});
+    request.statusCallbacks.push_back([](TuyaBLEDevice*, TuyaBLERequestStatus) {});
+    TEST_ASSERT_FALSE(requests.add(request, 0));
+    TEST_ASSERT_TRUE(static_cast<bool>(request.handler));
+    TEST_ASSERT_EQUAL(1, request.statusCallbacks.size());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testHandlersGetTheStatusCallbacksOfTheirRequest);
+    RUN_TEST(testFailedRequestsCallTheirHandlers);
+    RUN_TEST(testRequestsThatOnlyWaitToBeSent);
+    RUN_TEST(testSentRequestsKeepWaitingForTheirResponse);
+    RUN_TEST(testExpiredRequests);
+    RUN_TEST(testFullTable);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
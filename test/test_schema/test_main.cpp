@@ -0,0 +1,186 @@
+#include "../TestSupport.h"
+
+#include "Buffer.h"
+#include "BufferView.h"
+#include "TuyaBLEDataPointReport.h"
+#include "TuyaDataPoint.h"
+#include "TuyaDataPointSchema.h"
+#include "TuyaDataPointStore.h"
+
+typedef TuyaDP<6, TuyaDPRaw, TuyaDPDirection::send> ShortRangeUnlock;
+typedef TuyaDP<9, uint8_t, TuyaDPDirection::receive> BatteryLevel;
+typedef TuyaDP<21, String, TuyaDPDirection::sendAndReceive> Name;
+typedef TuyaDP<47, bool, TuyaDPDirection::receive> UnlockStatus;
+typedef TuyaDP<60, int32_t, TuyaDPDirection::receive> Temperature;
+typedef TuyaDPSchema<ShortRangeUnlock, BatteryLevel, Name, UnlockStatus, Temperature> Schema;
+
+void testDecodesIntoTypedStorage() {
+    Schema schema;
+    TEST_ASSERT_FALSE(schema.has<UnlockStatus>());
+    TEST_ASSERT_TRUE(schema.get<UnlockStatus>(true));
+
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::boolean(47, false)));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::enumeration(9, 2)));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::string(21, String("front door"))));
+    TEST_ASSERT_TRUE(schema.has<UnlockStatus>());
+    TEST_ASSERT_FALSE(schema.get<UnlockStatus>(true));
+    TEST_ASSERT_EQUAL_UINT8(2, schema.get<BatteryLevel>(0));
+    TEST_ASSERT_TRUE(schema.get<Name>(String()) == String("front door"));
+    TEST_ASSERT_FALSE(schema.has<Temperature>());
+
+    // unknown datapoints, datapoints we only send and datapoints of another type than declared aren't decoded
+    const uint8_t payload[] = {1, 1};
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::notInSchema == schema.decode(TuyaDataPoint::value(99, 1)));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::notInSchema == schema.decode(TuyaDataPoint::raw(6, BufferView(payload, sizeof(payload)))));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::notInSchema == schema.decode(TuyaDataPoint::value(47, 1)));
+    TEST_ASSERT_FALSE(schema.get<UnlockStatus>(true));
+
+    schema.clear();
+    TEST_ASSERT_FALSE(schema.has<UnlockStatus>());
+}
+
+void testDecodedPayloadsAreCopied() {
+    typedef TuyaDP<12, TuyaDPRaw, TuyaDPDirection::receive> Log;
+    TuyaDPSchema<Log> schema;
+
+    const uint8_t payload[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+    {
+        TuyaDataPoint reported = TuyaDataPoint::raw(12, BufferView(payload, sizeof(payload)));
+        TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(reported));
+    }
+
+    // the reported datapoint is gone, the schema has its own copy
+    BufferView log = schema.get<Log>(BufferView());
+    TEST_ASSERT_EQUAL(sizeof(payload), log.size());
+    TEST_ASSERT_EQUAL_MEMORY(payload, log.data(), sizeof(payload));
+}
+
+void testReportsWhetherTheValueChanged() {
+    Schema schema;
+    TuyaDataPoint unlocked = TuyaDataPoint::boolean(47, true);
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(unlocked));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::unchanged == schema.decode(unlocked));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::boolean(47, false)));
+
+    // the first report counts as a change, even if it's the same as the default of the storage
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::value(60, 0)));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::string(21, String())));
+
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::string(21, String("front door"))));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::unchanged == schema.decode(TuyaDataPoint::string(21, String("front door"))));
+    TEST_ASSERT_TRUE(TuyaDPDecodeResult::changed == schema.decode(TuyaDataPoint::string(21, String("front doors"))));
+}
+
+void testStringsAreCopiedOut() {
+    Schema schema;
+    schema.decode(TuyaDataPoint::string(21, String("front door")));
+
+    String name = schema.get<Name>(String());
+    schema.decode(TuyaDataPoint::string(21, String("back door, reported again with a longer name")));
+    TEST_ASSERT_TRUE(name == String("front door"));
+    TEST_ASSERT_TRUE(schema.get<Name>(String()) == String("back door, reported again with a longer name"));
+}
+
+void testStoredDataPointsDontMove() {
+    // one payload inline and one on the heap, then a report of every other id
+    const uint8_t shortPayload[] = {1, 2, 3};
+    const uint8_t longPayload[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+    TuyaDataPointStore store;
+    store.set(TuyaDataPoint::raw(1, BufferView(shortPayload, sizeof(shortPayload))));
+    store.set(TuyaDataPoint::raw(2, BufferView(longPayload, sizeof(longPayload))));
+    const TuyaDataPoint* first = store.find(1);
+    BufferView shortView = first->raw();
+    BufferView longView = store.find(2)->raw();
+
+    for(size_t dp = 0; dp < TuyaDataPointStore::numberOfIds; dp++) {
+        if(dp != 1 && dp != 2) store.set(TuyaDataPoint::value(static_cast<uint8_t>(dp), static_cast<int32_t>(dp)));
+    }
+    TEST_ASSERT_EQUAL(TuyaDataPointStore::numberOfIds, store.size());
+
+    TEST_ASSERT_TRUE(store.find(1) == first);
+    TEST_ASSERT_TRUE(store.find(1)->raw().data() == shortView.data());
+    TEST_ASSERT_EQUAL_MEMORY(shortPayload, shortView.data(), sizeof(shortPayload));
+    TEST_ASSERT_TRUE(store.find(2)->raw().data() == longView.data());
+    TEST_ASSERT_EQUAL_MEMORY(longPayload, longView.data(), sizeof(longPayload));
+
+    // a copy gets slots of its own
+    TuyaDataPointStore copy = store;
+    TEST_ASSERT_EQUAL(store.size(), copy.size());
+    BufferView copiedView = copy.find(2)->raw();
+    TEST_ASSERT_FALSE(copiedView.data() == longView.data());
+    TEST_ASSERT_EQUAL_MEMORY(longPayload, copiedView.data(), sizeof(longPayload));
+}
+
+void testViewsOnTheStoreSurviveOtherReports() {
+    // a short payload, stored inline in the datapoint itself
+    const uint8_t payload[] = {1, 2, 3};
+    TuyaDataPointStore store;
+    store.set(TuyaDataPoint::raw(12, BufferView(payload, sizeof(payload))));
+    BufferView log = store.find(12, TuyaDataPointType::raw)->raw();
+
+    for(size_t dp = 0; dp < TuyaDataPointStore::numberOfIds; dp++) {
+        if(dp != 12) store.set(TuyaDataPoint::value(static_cast<uint8_t>(dp), 1));
+    }
+
+    TEST_ASSERT_TRUE(store.find(12, TuyaDataPointType::raw)->raw().data() == log.data());
+    TEST_ASSERT_EQUAL_MEMORY(payload, log.data(), sizeof(payload));
+}
+
+void testBooleansAreWhatsOnTheWire() {
+    // `TuyaDataPoint` reads booleans inverted, the schema doesn't
+    typedef TuyaDP<48, bool, TuyaDPDirection::sendAndReceive> Switch;
+    TuyaDPSchema<Switch> schema;
+
+    const uint8_t on[] = {1};
+    TuyaBLEReceivedDataPointItem reported{48, TuyaDataPointType::boolean, BufferView(on, sizeof(on))};
+    schema.decode(reported.toDataPoint());
+    TEST_ASSERT_FALSE(reported.toDataPoint().boolean());
+    TEST_ASSERT_TRUE(schema.get<Switch>(false));
+
+    Buffer encoded;
+    TuyaDPSchema<Switch>::make<Switch>(true).encode(encoded, 1);
+    const uint8_t expected[] = {48, 1, 1, 1};
+    TEST_ASSERT_EQUAL(sizeof(expected), encoded.size());
+    TEST_ASSERT_EQUAL_MEMORY(expected, encoded.data(), sizeof(expected));
+}
+
+void testMake() {
+    const uint8_t payload[] = {1, 1};
+    TuyaDataPoint unlock = Schema::make<ShortRangeUnlock>(BufferView(payload, sizeof(payload)));
+    TEST_ASSERT_TRUE(unlock == TuyaDataPoint::raw(6, BufferView(payload, sizeof(payload))));
+    TEST_ASSERT_TRUE(Schema::make<Name>(String("hall")) == TuyaDataPoint::string(21, String("hall")));
+}
+
+void benchmarkSchema() {
+    TuyaDataPointStore store;
+    store.set(TuyaDataPoint::boolean(47, true));
+    store.set(TuyaDataPoint::enumeration(9, 2));
+
+    Schema schema;
+    schema.decode(TuyaDataPoint::boolean(47, true));
+    TuyaDataPoint batteryLevel = TuyaDataPoint::enumeration(9, 2);
+
+    TuyaDataPoint name = TuyaDataPoint::string(21, String("front door"));
+    schema.decode(name);
+
+    benchmark("schema decode", 10000, [&schema, &batteryLevel]() { schema.decode(batteryLevel); });
+    benchmark("schema decode unchanged string", 10000, [&schema, &name]() { schema.decode(name); });
+    benchmark("schema get", 10000, [&schema]() { schema.get<UnlockStatus>(false); });
+    benchmark("store find", 10000, [&store]() { store.find(47, TuyaDataPointType::boolean); });
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testDecodesIntoTypedStorage);
+    RUN_TEST(testDecodedPayloadsAreCopied);
+    RUN_TEST(testReportsWhetherTheValueChanged);
+    RUN_TEST(testStringsAreCopiedOut);
+    RUN_TEST(testStoredDataPointsDontMove);
+    RUN_TEST(testViewsOnTheStoreSurviveOtherReports);
+    RUN_TEST(testBooleansAreWhatsOnTheWire);
+    RUN_TEST(testMake);
+    RUN_TEST(benchmarkSchema);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
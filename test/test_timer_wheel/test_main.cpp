@@ -0,0 +1,118 @@
+#include "../TestSupport.h"
+
+#include <limits.h>
+
+#include "TuyaBLETimerWheel.h"
+
+typedef TuyaBLETimerWheel<4> TimerWheel;
+
+/// advances `wheel` from `fromMs` in steps of `stepMs` until `timer` fires, returns how long that took
+static unsigned long advanceUntilFired(TimerWheel& wheel, size_t timer, unsigned long fromMs, unsigned long stepMs) {
+    bool hasFired = false;
+    unsigned long nowMs = fromMs;
+    for(size_t step = 0; step < 10000; step++, nowMs += stepMs) {
+        wheel.advance(nowMs, [&](size_t expired) {
+            if(expired == timer) hasFired = true;
+        });
+        if(hasFired) return nowMs - fromMs;
+    }
+
+    TEST_FAIL_MESSAGE("the timer didn't fire");
+    return 0;
+}
+
+void testFiresWithinATickAfterTheDeadline() {
+    TimerWheel wheel;
+    wheel.schedule(0, 1000, 1120);
+
+    unsigned long elapsedMs = advanceUntilFired(wheel, 0, 1000, 1);
+    TEST_ASSERT_GREATER_OR_EQUAL(120, elapsedMs);
+    TEST_ASSERT_LESS_THAN(120 + 50, elapsedMs);
+    TEST_ASSERT_FALSE(wheel.isScheduled(0));
+}
+
+void testKeepsTheRemainderOfATick() {
+    // steps shorter than a tick still add up
+    TimerWheel wheel;
+    wheel.schedule(0, 0, 100);
+    unsigned long elapsedMs = advanceUntilFired(wheel, 0, 0, 30);
+    TEST_ASSERT_GREATER_OR_EQUAL(100, elapsedMs);
+    TEST_ASSERT_LESS_THAN(100 + 50 + 30, elapsedMs);
+}
+
+void testKeepsRunningWhenMillisWraps() {
+    // a timer that expires before `millis()` wraps, and one that expires after it
+    TimerWheel wheel;
+    unsigned long startMs = ULONG_MAX - 1000;
+    wheel.schedule(0, startMs, startMs + 500);
+    wheel.schedule(1, startMs, startMs + 3000);
+
+    unsigned long elapsedMs = advanceUntilFired(wheel, 0, startMs, 10);
+    TEST_ASSERT_GREATER_OR_EQUAL(500, elapsedMs);
+    TEST_ASSERT_LESS_THAN(500 + 50, elapsedMs);
+
+    elapsedMs += advanceUntilFired(wheel, 1, startMs + elapsedMs, 10);
+    TEST_ASSERT_GREATER_OR_EQUAL(3000, elapsedMs);
+    TEST_ASSERT_LESS_THAN(3000 + 50, elapsedMs);
+
+    // and timers scheduled after the wrap fire too
+    unsigned long nowMs = startMs + elapsedMs;
+    TEST_ASSERT_TRUE(nowMs < startMs);
+    wheel.schedule(2, nowMs, nowMs + 200);
+    elapsedMs = advanceUntilFired(wheel, 2, nowMs, 10);
+    TEST_ASSERT_GREATER_OR_EQUAL(200, elapsedMs);
+    TEST_ASSERT_LESS_THAN(200 + 50, elapsedMs);
+}
+
+void testEarlierTimeDoesntMoveTheWheel() {
+    // another task may have read `millis()` just before the wheel was advanced
+    TimerWheel wheel;
+    wheel.schedule(0, 1000, 1100);
+    wheel.advance(1060, [](size_t) {});
+    bool hasFired = false;
+    wheel.advance(1040, [&](size_t) { hasFired = true; });
+    TEST_ASSERT_FALSE(hasFired);
+    TEST_ASSERT_TRUE(wheel.isScheduled(0));
+    TEST_ASSERT_GREATER_OR_EQUAL(1100 - 1060, advanceUntilFired(wheel, 0, 1060, 1));
+}
+
+void testStartsOverAfterBeingIdle() {
+    // without timers nothing advances the wheel, here for longer than half the range of `millis()`
+    TimerWheel wheel;
+    wheel.schedule(0, 0, 100);
+    TEST_ASSERT_EQUAL(100, advanceUntilFired(wheel, 0, 0, 50));
+
+    unsigned long nowMs = ULONG_MAX / 2 + 1000;
+    wheel.schedule(1, nowMs, nowMs + 100);
+    unsigned long elapsedMs = advanceUntilFired(wheel, 1, nowMs, 10);
+    TEST_ASSERT_GREATER_OR_EQUAL(100, elapsedMs);
+    TEST_ASSERT_LESS_THAN(100 + 50, elapsedMs);
+}
+
+void testTimerScheduledWhileFiringFiresLater() {
+    TimerWheel wheel;
+    wheel.schedule(0, 0, 100);
+    size_t numberOfFirings = 0;
+    for(unsigned long nowMs = 0; nowMs < 1000; nowMs += 10) {
+        wheel.advance(nowMs, [&](size_t timer) {
+            numberOfFirings += 1;
+            wheel.schedule(timer, nowMs, nowMs + 300);
+        });
+    }
+
+    // at 100, 400 and 700
+    TEST_ASSERT_EQUAL(3, numberOfFirings);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(testFiresWithinATickAfterTheDeadline);
+    RUN_TEST(testKeepsTheRemainderOfATick);
+    RUN_TEST(testKeepsRunningWhenMillisWraps);
+    RUN_TEST(testEarlierTimeDoesntMoveTheWheel);
+    RUN_TEST(testStartsOverAfterBeingIdle);
+    RUN_TEST(testTimerScheduledWhileFiringFiresLater);
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)
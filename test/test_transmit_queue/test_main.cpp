@@ -0,0 +1,114 @@
+#include "../TestSupport.h"
+
+#include <vector>
+
+#include "Buffer.h"
+#include "CryptoHelper.h"
+#include "TuyaBLEFrameEncoder.h"
+#include "TuyaBLETransmitQueue.h"
+
+static const uint8_t keyBytes[16] = {0x00, 0x07, 0x0E, 0x15, 0x1C, 0x23, 0x2A, 0x31, 0x38, 0x3F, 0x46, 0x4D, 0x54, 0x5B, 0x62, 0x69};
+static const uint8_t iv[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F};
+
+/// what the queue wrote and completed. There are no tasks on the host, so messages are written by `enqueue()`
+struct Transmissions {
+    std::vector<Buffer> packets;
+    std::vector<uint32_t> completedTags;
+    std::vector<bool> completedSuccesses;
+    bool isWriteRefused = false;
+
+    void start(TuyaBLETransmitQueue& queue) {
+        TuyaBLETransmitQueue::Configuration configuration;
+        configuration.creditIntervalMs = 0;
+        configuration.maximumNumberOfWriteRetries = 1;
+        configuration.retryBackoffMs = 0;
+        queue.setConfiguration(configuration);
+
+        queue.start([this](const uint8_t* data, size_t length) {
+            if(isWriteRefused) return false;
+            packets.push_back(Buffer(BufferView(data, length)));
+            return true;
+        }, [this](uint32_t tag, bool success) {
+            completedTags.push_back(tag);
+            completedSuccesses.push_back(success);
+        });
+    }
+};
+
+void testMessagesAreEncodedIntoTheQueue() {
+    TuyaBLETransmitQueue queue;
+    Transmissions transmissions;
+    transmissions.start(queue);
+    TEST_ASSERT_TRUE(queue.isRunning());
+    TEST_ASSERT_FALSE(queue.hasSenderTask());
+
+    AesCbc128Key key(keyBytes);
+    Buffer data({1, 1, 1, 1, 2, 2, 4, 0, 0, 1, 44});
+    TuyaBLEEncodedFrame expected;
+    TuyaBLEFrameEncoder::encode(expected, TuyaBLESecurityFlag::sessionKey, key, iv, 12, 0, TuyaBLEFunctionCode::senderDps, data, 3, 20);
+
+    // the encoder is called with the queue's storage, the completion function gets the tag
+    TEST_ASSERT_TRUE(queue.enqueue([&](TuyaBLEEncodedFrame& frame) {
+        TuyaBLEFrameEncoder::encode(frame, TuyaBLESecurityFlag::sessionKey, key, iv, 12, 0, TuyaBLEFunctionCode::senderDps, data, 3, 20);
+    }, 12));
+
+    TEST_ASSERT_EQUAL(expected.numberOfPackets(), transmissions.packets.size());
+    for(size_t index = 0; index < expected.numberOfPackets(); index++) {
+        TEST_ASSERT_EQUAL(expected.packet(index).size(), transmissions.packets[index].size());
+        TEST_ASSERT_EQUAL_MEMORY(expected.packet(index).data(), transmissions.packets[index].data(), transmissions.packets[index].size());
+    }
+    TEST_ASSERT_EQUAL(1, transmissions.completedTags.size());
+    TEST_ASSERT_EQUAL(12, transmissions.completedTags[0]);
+    TEST_ASSERT_TRUE(transmissions.completedSuccesses[0]);
+    TEST_ASSERT_EQUAL(0, queue.numberOfQueuedMessages());
+}
+
+void testRefusedWritesFailTheMessage() {
+    TuyaBLETransmitQueue queue;
+    Transmissions transmissions;
+    transmissions.start(queue);
+    transmissions.isWriteRefused = true;
+
+    TEST_ASSERT_TRUE(queue.enqueue([](TuyaBLEEncodedFrame& frame) {
+        TuyaBLEFrameEncoder::encode(frame, TuyaBLESecurityFlag::sessionKey, AesCbc128Key(keyBytes), iv, 3, 0, TuyaBLEFunctionCode::senderDeviceStatus, Buffer(), 3, 20);
+    }, 3));
+    TEST_ASSERT_EQUAL(1, transmissions.completedTags.size());
+    TEST_ASSERT_EQUAL(3, transmissions.completedTags[0]);
+    TEST_ASSERT_FALSE(transmissions.completedSuccesses[0]);
+}
+
+void testMessagesThatArentQueued() {
+    TuyaBLETransmitQueue queue;
+    Transmissions transmissions;
+    bool isEncoderCalled = false;
+
+    // before it's started
+    TEST_ASSERT_FALSE(queue.enqueue([&](TuyaBLEEncodedFrame&) { isEncoderCalled = true; }, 1));
+    TEST_ASSERT_FALSE(isEncoderCalled);
+
+    // without packets
+    transmissions.start(queue);
+    TEST_ASSERT_FALSE(queue.enqueue([&](TuyaBLEEncodedFrame&) { isEncoderCalled = true; }, 2));
+    TEST_ASSERT_TRUE(isEncoderCalled);
+
+    // after it's stopped
+    queue.stop();
+    TEST_ASSERT_FALSE(queue.isRunning());
+    TEST_ASSERT_FALSE(queue.enqueue([](TuyaBLEEncodedFrame&) {}, 3));
+    TEST_ASSERT_EQUAL(0, transmissions.completedTags.size());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+#ifdef ARDUINO
+    // on a device the queue writes from a task of its own, these tests rely on it writing from `enqueue()`
+    TEST_MESSAGE("the transmit queue is only tested on the host");
+#else
+    RUN_TEST(testMessagesAreEncodedIntoTheQueue);
+    RUN_TEST(testRefusedWritesFailTheMessage);
+    RUN_TEST(testMessagesThatArentQueued);
+#endif
+    return UNITY_END();
+}
+
+TEST_SUITE_MAIN(runTests)